@@ -5,27 +5,32 @@
  *
  * Arguments:
  *
- * data  Pointer to source volume
+ * data  Pointer to source volume. Samples are converted to float, see Load4_As_Float.
  * x0    .
  * y0    Start copy at this location
  * z0    .
  * nx    .
  * ny    Source volume dimensions
  * nz    .
+ * ldx   Distance between consecutive y rows of source volume, in samples. ldx >= nx.
+ * ldy   Number of y rows between consecutive z slices of source volume. ldy >= ny.
  * work  Pointer to destination block
  * bx    . Must be multiple of 4.
  * by    Destination block dimensions.
  * bz    .
  *
  */
-void Copy_To_Block(
-	float* data,
+template<typename T>
+static void _Copy_To_Block(
+	T* data,
 	int x0,
 	int y0,
 	int z0,
 	int nx,
 	int ny,
 	int nz,
+	int ldx,
+	int ldy,
 	__m128* work,
 	int bx,
 	int by,
@@ -41,7 +46,7 @@ void Copy_To_Block(
 	for (iz = z0;  iz < z0+bz && iz < nz;  ++iz)
 	{
 		int iy = y0;
-		__m128* src = (__m128*)(data + (long)(iz*ny + iy)*nx + x0);
+		T* src = data + ((long)iz*(long)ldy + (long)iy)*(long)ldx + x0;
 		__m128* dst = work + (long)((iz-z0)*by + (iy-y0))*_mm_bx;
 		if (nclipx <= 0)
 		{
@@ -50,8 +55,8 @@ void Copy_To_Block(
 				for (;  iy < y_stop;  ++iy)
 				{
 					//printf("....copying iz=%d,iy=%d\n",iz,iy);
-					*(dst++) = _mm_loadu_ps((float*)(src));
-					src = (__m128*)(((float*)src) + nx);
+					*(dst++) = Load4_As_Float(src);
+					src += ldx;
 				}
 			}
 			else if (_mm_bx == 2)
@@ -59,9 +64,9 @@ void Copy_To_Block(
 				for (;  iy < y_stop;  ++iy)
 				{
 					//printf("....copying iz=%d,iy=%d\n",iz,iy);
-					*(dst++) = _mm_loadu_ps((float*)(src));
-					*(dst++) = _mm_loadu_ps((float*)(src+1));
-					src = (__m128*)(((float*)src) + nx);
+					*(dst++) = Load4_As_Float(src);
+					*(dst++) = Load4_As_Float(src+4);
+					src += ldx;
 				}
 			}
 			else if (_mm_bx == 4)
@@ -69,11 +74,11 @@ void Copy_To_Block(
 				for (;  iy < y_stop;  ++iy)
 				{
 					//printf("....copying iz=%d,iy=%d\n",iz,iy);
-					*(dst++) = _mm_loadu_ps((float*)(src));
-					*(dst++) = _mm_loadu_ps((float*)(src+1));
-					*(dst++) = _mm_loadu_ps((float*)(src+2));
-					*(dst++) = _mm_loadu_ps((float*)(src+3));
-					src = (__m128*)(((float*)src) + nx);
+					*(dst++) = Load4_As_Float(src);
+					*(dst++) = Load4_As_Float(src+4);
+					*(dst++) = Load4_As_Float(src+8);
+					*(dst++) = Load4_As_Float(src+12);
+					src += ldx;
 				}
 			}
 			else
@@ -82,8 +87,8 @@ void Copy_To_Block(
 				{
 					//printf("....copying iz=%d,iy=%d\n",iz,iy);
 					int ix;
-					for (ix = 0;  ix < clipped_mm_bx;  ++ix) *(dst++) = _mm_loadu_ps((float*)(src+ix));
-					src = (__m128*)(((float*)src) + nx);
+					for (ix = 0;  ix < clipped_mm_bx;  ++ix) *(dst++) = Load4_As_Float(src+4*ix);
+					src += ldx;
 				}
 			}
 		}
@@ -93,10 +98,10 @@ void Copy_To_Block(
 			{
 				//printf("....copying iz=%d,iy=%d\n",iz,iy);
 				int ix;
-				for (ix = 0;  ix < clipped_mm_bx;  ++ix) dst[ix] = _mm_loadu_ps((float*)(src+ix));
-				for (ix=ix*4;  ix < clipped_bx;  ++ix) ((float*)dst)[ix] = ((float*)src)[ix];
+				for (ix = 0;  ix < clipped_mm_bx;  ++ix) dst[ix] = Load4_As_Float(src+4*ix);
+				for (ix=ix*4;  ix < clipped_bx;  ++ix) ((float*)dst)[ix] = Load1_As_Float(src+ix);
 				for (;  ix < bx;  ++ix) ((float*)dst)[ix] = 0.0f;
-				src = (__m128*)(((float*)src) + nx);
+				src += ldx;
 				dst += _mm_bx;
 			}
 		}
@@ -124,27 +129,32 @@ void Copy_To_Block(
  * bx    . Must be multiple of 4.
  * by    Destination block dimensions.
  * bz    .
- * data  Pointer to source volume
+ * data  Pointer to destination volume. Samples are converted from float, see Store4_From_Float.
  * x0    .
  * y0    Start copy at this location
  * z0    .
  * nx    .
- * ny    Source volume dimensions
+ * ny    Destination volume dimensions
  * nz    .
+ * ldx   Distance between consecutive y rows of destination volume, in samples. ldx >= nx.
+ * ldy   Number of y rows between consecutive z slices of destination volume. ldy >= ny.
  *
  */
-void Copy_From_Block(
+template<typename T>
+static void _Copy_From_Block(
 	__m128* work,
 	int bx,
 	int by,
 	int bz,
-	float* data,
+	T* data,
 	int x0,
 	int y0,
 	int z0,
 	int nx,
 	int ny,
-	int nz
+	int nz,
+	int ldx,
+	int ldy
 	)
 {
 	int _mm_bx = bx >> 2;
@@ -155,36 +165,36 @@ void Copy_From_Block(
 	for (int iz = z0;  iz < z0+bz && iz < nz;  ++iz)
 	{
 		int iy = y0;
-		__m128i* dst = (__m128i*)(data + (long)(iz*ny + iy)*nx + x0);
-		__m128i* src = (__m128i*)work + (long)((iz-z0)*by + (iy-y0))*_mm_bx;
+		T* dst = data + ((long)iz*(long)ldy + (long)iy)*(long)ldx + x0;
+		__m128* src = work + (long)((iz-z0)*by + (iy-y0))*_mm_bx;
 		if (nclipx <= 0)
 		{
 			if (_mm_bx == 1)
 			{
 				for (;  iy < y_stop;  ++iy)
 				{
-					_mm_storeu_si128(dst, _mm_load_si128(src++));
-					dst = (__m128i*)(((float*)dst) + nx);
+					Store4_From_Float(dst, *(src++));
+					dst += ldx;
 				}
 			}
 			else if (_mm_bx == 2)
 			{
 				for (;  iy < y_stop;  ++iy)
 				{
-					_mm_storeu_si128(dst, _mm_load_si128(src++));
-					_mm_storeu_si128(dst+1, _mm_load_si128(src++));
-					dst = (__m128i*)(((float*)dst) + nx);
+					Store4_From_Float(dst, *(src++));
+					Store4_From_Float(dst+4, *(src++));
+					dst += ldx;
 				}
 			}
 			else if (_mm_bx == 4)
 			{
 				for (;  iy < y_stop;  ++iy)
 				{
-					_mm_storeu_si128(dst, _mm_load_si128(src++));
-					_mm_storeu_si128(dst+1, _mm_load_si128(src++));
-					_mm_storeu_si128(dst+2, _mm_load_si128(src++));
-					_mm_storeu_si128(dst+3, _mm_load_si128(src++));
-					dst = (__m128i*)(((float*)dst) + nx);
+					Store4_From_Float(dst, *(src++));
+					Store4_From_Float(dst+4, *(src++));
+					Store4_From_Float(dst+8, *(src++));
+					Store4_From_Float(dst+12, *(src++));
+					dst += ldx;
 				}
 			}
 			else
@@ -192,8 +202,8 @@ void Copy_From_Block(
 				for (;  iy < y_stop;  ++iy)
 				{
 					int ix;
-					for (ix = 0;  ix < clipped_mm_bx;  ++ix) _mm_storeu_si128(dst+ix, _mm_load_si128(src++));
-					dst = (__m128i*)(((float*)dst) + nx);
+					for (ix = 0;  ix < clipped_mm_bx;  ++ix) Store4_From_Float(dst+4*ix, *(src++));
+					dst += ldx;
 				}
 			}
 		}
@@ -202,11 +212,466 @@ void Copy_From_Block(
 			for (;  iy < y_stop;  ++iy)
 			{
 				int ix;
-				for (ix = 0;  ix < clipped_mm_bx;  ++ix) _mm_storeu_si128(dst+ix, _mm_load_si128(src+ix));
-				for (ix=ix*4;  ix < clipped_bx;  ++ix) ((float*)dst)[ix] = ((float*)src)[ix];
-				dst = (__m128i*)(((float*)dst) + nx);
+				for (ix = 0;  ix < clipped_mm_bx;  ++ix) Store4_From_Float(dst+4*ix, src[ix]);
+				for (ix=ix*4;  ix < clipped_bx;  ++ix) Store1_From_Float(dst+ix, ((float*)src)[ix]);
+				dst += ldx;
 				src += _mm_bx;
 			}
 		}
 	}
 }
+
+/*!
+ * Copy a block of dimension bx*by*bz from a volume stored with z as the fast axis, i.e. sample (ix,iy,iz) is
+ * data[(ix*ny+iy)*nz+iz] (trace-major). The block is transposed on the fly, so it ends up in the same x-fast
+ * layout Copy_To_Block produces. Arguments are the same as for Copy_To_Block.
+ * Blocks that are entirely inside the volume are gathered 4x4 samples at a time.
+ */
+template<typename T>
+static void _Copy_To_Block_Z_Fast(
+	T* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz,
+	__m128* work,
+	int bx,
+	int by,
+	int bz
+	)
+{
+	long stride_x = (long)ny * (long)nz;
+	if (x0+bx <= nx && y0+by <= ny && z0+bz <= nz && (bz & 3) == 0)
+	{
+		int _mm_bx = bx >> 2;
+		for (int iy = 0;  iy < by;  ++iy)
+		{
+			for (int ix = 0;  ix < bx;  ix+=4)
+			{
+				T* src = data + ((long)(x0+ix)*(long)ny + (long)(y0+iy))*(long)nz + z0;
+				__m128* dst = work + (long)iy*_mm_bx + (ix>>2);
+				for (int iz = 0;  iz < bz;  iz+=4)
+				{
+					__m128 r0 = Load4_As_Float(src+iz);
+					__m128 r1 = Load4_As_Float(src+stride_x+iz);
+					__m128 r2 = Load4_As_Float(src+2*stride_x+iz);
+					__m128 r3 = Load4_As_Float(src+3*stride_x+iz);
+					_MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+					long idx = (long)iz*by*_mm_bx;
+					long stride_z = (long)by*_mm_bx;
+					dst[idx] = r0;
+					dst[idx+stride_z] = r1;
+					dst[idx+2*stride_z] = r2;
+					dst[idx+3*stride_z] = r3;
+				}
+			}
+		}
+	}
+	else
+	{
+		float* dst = (float*)work;
+		for (int ix = 0;  ix < bx;  ++ix)
+		{
+			for (int iy = 0;  iy < by;  ++iy)
+			{
+				bool inside = (x0+ix < nx && y0+iy < ny);
+				T* src = data + ((long)(x0+ix)*(long)ny + (long)(y0+iy))*(long)nz + z0;
+				for (int iz = 0;  iz < bz;  ++iz)
+				{
+					dst[((long)iz*by+iy)*bx+ix] = (inside && z0+iz < nz) ? Load1_As_Float(src+iz) : 0.0f;
+				}
+			}
+		}
+	}
+}
+
+/*!
+ * Copy a block of dimensions bx*by*bz to a volume stored with z as the fast axis. Inverse of Copy_To_Block_Z_Fast.
+ * Arguments are the same as for Copy_From_Block.
+ */
+template<typename T>
+static void _Copy_From_Block_Z_Fast(
+	__m128* work,
+	int bx,
+	int by,
+	int bz,
+	T* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz
+	)
+{
+	long stride_x = (long)ny * (long)nz;
+	if (x0+bx <= nx && y0+by <= ny && z0+bz <= nz && (bz & 3) == 0)
+	{
+		int _mm_bx = bx >> 2;
+		for (int iy = 0;  iy < by;  ++iy)
+		{
+			for (int ix = 0;  ix < bx;  ix+=4)
+			{
+				T* dst = data + ((long)(x0+ix)*(long)ny + (long)(y0+iy))*(long)nz + z0;
+				__m128* src = work + (long)iy*_mm_bx + (ix>>2);
+				for (int iz = 0;  iz < bz;  iz+=4)
+				{
+					long idx = (long)iz*by*_mm_bx;
+					long stride_z = (long)by*_mm_bx;
+					__m128 r0 = src[idx];
+					__m128 r1 = src[idx+stride_z];
+					__m128 r2 = src[idx+2*stride_z];
+					__m128 r3 = src[idx+3*stride_z];
+					_MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+					Store4_From_Float(dst+iz,r0);
+					Store4_From_Float(dst+stride_x+iz,r1);
+					Store4_From_Float(dst+2*stride_x+iz,r2);
+					Store4_From_Float(dst+3*stride_x+iz,r3);
+				}
+			}
+		}
+	}
+	else
+	{
+		float* src = (float*)work;
+		for (int ix = 0;  ix < bx && x0+ix < nx;  ++ix)
+		{
+			for (int iy = 0;  iy < by && y0+iy < ny;  ++iy)
+			{
+				T* dst = data + ((long)(x0+ix)*(long)ny + (long)(y0+iy))*(long)nz + z0;
+				for (int iz = 0;  iz < bz && z0+iz < nz;  ++iz) Store1_From_Float(dst+iz, src[((long)iz*by+iy)*bx+ix]);
+			}
+		}
+	}
+}
+
+/*!
+ * Copy a block of dimension bx*by*bz from a volume with nc interleaved components per sample,
+ * i.e. component ic of sample (ix,iy,iz) is data[((iz*ny+iy)*nx+ix)*nc+ic].
+ * All components are gathered in one sweep, component ic goes to its own block at work + ic*work_stride/4.
+ * work_stride is the distance between component blocks in floats, must be a multiple of 4.
+ * Samples outside the volume are zero, like Copy_To_Block.
+ */
+template<typename T>
+static void _Copy_To_Block_Interleaved(
+	T* data,
+	int nc,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz,
+	__m128* work,
+	long work_stride,
+	int bx,
+	int by,
+	int bz
+	)
+{
+	int clipped_bx = x0+bx < nx ? bx : nx - x0;
+	for (int iz = 0;  iz < bz;  ++iz)
+	{
+		for (int iy = 0;  iy < by;  ++iy)
+		{
+			float* dst = (float*)work + ((long)iz*by + iy)*bx;
+			if (z0+iz >= nz || y0+iy >= ny)
+			{
+				for (int ic = 0;  ic < nc;  ++ic) memset(dst+ic*work_stride,0,sizeof(float)*bx);
+				continue;
+			}
+			T* src = data + (((long)(z0+iz)*(long)ny + (long)(y0+iy))*(long)nx + x0)*nc;
+			int ix = 0;
+			if (nc == 2)
+			{
+				// e.g. complex samples, split real and imaginary parts 4 samples at a time.
+				for (;  ix+4 <= clipped_bx;  ix+=4)
+				{
+					__m128 v0 = Load4_As_Float(src+2*ix);
+					__m128 v1 = Load4_As_Float(src+2*ix+4);
+					_mm_storeu_ps(dst+ix, _mm_shuffle_ps(v0,v1,_MM_SHUFFLE(2,0,2,0)));
+					_mm_storeu_ps(dst+work_stride+ix, _mm_shuffle_ps(v0,v1,_MM_SHUFFLE(3,1,3,1)));
+				}
+			}
+			for (;  ix < clipped_bx;  ++ix)
+				for (int ic = 0;  ic < nc;  ++ic)
+					dst[ic*work_stride+ix] = Load1_As_Float(src+ix*nc+ic);
+			for (;  ix < bx;  ++ix)
+				for (int ic = 0;  ic < nc;  ++ic)
+					dst[ic*work_stride+ix] = 0.0f;
+		}
+	}
+}
+
+/*!
+ * Copy nc component blocks to a volume with nc interleaved components per sample. Inverse of Copy_To_Block_Interleaved.
+ */
+template<typename T>
+static void _Copy_From_Block_Interleaved(
+	__m128* work,
+	long work_stride,
+	int bx,
+	int by,
+	int bz,
+	T* data,
+	int nc,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz
+	)
+{
+	int clipped_bx = x0+bx < nx ? bx : nx - x0;
+	for (int iz = 0;  iz < bz && z0+iz < nz;  ++iz)
+	{
+		for (int iy = 0;  iy < by && y0+iy < ny;  ++iy)
+		{
+			float* src = (float*)work + ((long)iz*by + iy)*bx;
+			T* dst = data + (((long)(z0+iz)*(long)ny + (long)(y0+iy))*(long)nx + x0)*nc;
+			int ix = 0;
+			if (nc == 2)
+			{
+				for (;  ix+4 <= clipped_bx;  ix+=4)
+				{
+					__m128 re = _mm_loadu_ps(src+ix);
+					__m128 im = _mm_loadu_ps(src+work_stride+ix);
+					Store4_From_Float(dst+2*ix, _mm_unpacklo_ps(re,im));
+					Store4_From_Float(dst+2*ix+4, _mm_unpackhi_ps(re,im));
+				}
+			}
+			for (;  ix < clipped_bx;  ++ix)
+				for (int ic = 0;  ic < nc;  ++ic)
+					Store1_From_Float(dst+ix*nc+ic, src[ic*work_stride+ix]);
+		}
+	}
+}
+
+/*!
+ * Add a block to a float volume instead of overwriting it. Computes data += alpha * block when src is NULL,
+ * otherwise data += src * block, where src is a second volume with the same dimensions and strides as data.
+ * Remaining arguments are the same as for Copy_From_Block.
+ */
+static void _Accumulate_From_Block(
+	__m128* work,
+	int bx,
+	int by,
+	int bz,
+	float alpha,
+	const float* src,
+	float* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy
+	)
+{
+	int _mm_bx = bx >> 2;
+	int nclipx = (x0+bx) - nx;
+	int clipped_mm_bx = nclipx > 0 ? (bx - nclipx) >> 2 : bx >> 2;
+	int clipped_bx = nclipx > 0 ? (bx - nclipx) : bx;
+	int y_stop = y0+by < ny ? y0+by : ny;
+	__m128 _mm_alpha = _mm_set1_ps(alpha);
+	for (int iz = z0;  iz < z0+bz && iz < nz;  ++iz)
+	{
+		long off = ((long)iz*(long)ldy + (long)y0)*(long)ldx + x0;
+		__m128* blk = work + (long)((iz-z0)*by)*_mm_bx;
+		for (int iy = y0;  iy < y_stop;  ++iy)
+		{
+			float* dst = data + off;
+			int ix;
+			if (src != 0L)
+			{
+				const float* mul = src + off;
+				for (ix = 0;  ix < clipped_mm_bx;  ++ix)
+					_mm_storeu_ps(dst+4*ix, _mm_add_ps(_mm_loadu_ps(dst+4*ix), _mm_mul_ps(_mm_loadu_ps(mul+4*ix), blk[ix])));
+				for (ix=ix*4;  ix < clipped_bx;  ++ix) dst[ix] += mul[ix] * ((float*)blk)[ix];
+			}
+			else
+			{
+				for (ix = 0;  ix < clipped_mm_bx;  ++ix)
+					_mm_storeu_ps(dst+4*ix, _mm_add_ps(_mm_loadu_ps(dst+4*ix), _mm_mul_ps(_mm_alpha, blk[ix])));
+				for (ix=ix*4;  ix < clipped_bx;  ++ix) dst[ix] += alpha * ((float*)blk)[ix];
+			}
+			off += ldx;
+			blk += _mm_bx;
+		}
+	}
+}
+
+void Copy_To_Block(float* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,nx,ny,work,bx,by,bz);
+}
+
+void Copy_To_Block(double* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,nx,ny,work,bx,by,bz);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, float* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,nx,ny);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, double* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,nx,ny);
+}
+
+void Copy_To_Block(cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,nx,ny,work,bx,by,bz);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,nx,ny);
+}
+
+void Copy_To_Block(cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,nx,ny,work,bx,by,bz);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,nx,ny);
+}
+
+void Copy_To_Block(float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,ldx,ldy,work,bx,by,bz);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+}
+
+void Copy_To_Block(double* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,ldx,ldy,work,bx,by,bz);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, double* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+}
+
+void Copy_To_Block(cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,ldx,ldy,work,bx,by,bz);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+}
+
+void Copy_To_Block(cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block(data,x0,y0,z0,nx,ny,nz,ldx,ldy,work,bx,by,bz);
+}
+
+void Copy_From_Block(__m128* work, int bx, int by, int bz, cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	_Copy_From_Block(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+}
+
+void Copy_To_Block_Z_Fast(float* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block_Z_Fast(data,x0,y0,z0,nx,ny,nz,work,bx,by,bz);
+}
+
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, float* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Z_Fast(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_To_Block_Z_Fast(double* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block_Z_Fast(data,x0,y0,z0,nx,ny,nz,work,bx,by,bz);
+}
+
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, double* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Z_Fast(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_To_Block_Z_Fast(cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block_Z_Fast(data,x0,y0,z0,nx,ny,nz,work,bx,by,bz);
+}
+
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Z_Fast(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_To_Block_Z_Fast(cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz)
+{
+	_Copy_To_Block_Z_Fast(data,x0,y0,z0,nx,ny,nz,work,bx,by,bz);
+}
+
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Z_Fast(work,bx,by,bz,data,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_To_Block_Interleaved(float* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz)
+{
+	_Copy_To_Block_Interleaved(data,nc,x0,y0,z0,nx,ny,nz,work,work_stride,bx,by,bz);
+}
+
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, float* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Interleaved(work,work_stride,bx,by,bz,data,nc,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_To_Block_Interleaved(double* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz)
+{
+	_Copy_To_Block_Interleaved(data,nc,x0,y0,z0,nx,ny,nz,work,work_stride,bx,by,bz);
+}
+
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, double* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Interleaved(work,work_stride,bx,by,bz,data,nc,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_To_Block_Interleaved(cvx_float16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz)
+{
+	_Copy_To_Block_Interleaved(data,nc,x0,y0,z0,nx,ny,nz,work,work_stride,bx,by,bz);
+}
+
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, cvx_float16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Interleaved(work,work_stride,bx,by,bz,data,nc,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_To_Block_Interleaved(cvx_bfloat16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz)
+{
+	_Copy_To_Block_Interleaved(data,nc,x0,y0,z0,nx,ny,nz,work,work_stride,bx,by,bz);
+}
+
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, cvx_bfloat16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz)
+{
+	_Copy_From_Block_Interleaved(work,work_stride,bx,by,bz,data,nc,x0,y0,z0,nx,ny,nz);
+}
+
+void Copy_From_Block_Accumulate(__m128* work, int bx, int by, int bz, float alpha, float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	_Accumulate_From_Block(work,bx,by,bz,alpha,0L,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+}
+
+void Copy_From_Block_Multiply_Accumulate(__m128* work, int bx, int by, int bz, const float* src, float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	_Accumulate_From_Block(work,bx,by,bz,0.0f,src,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+}
@@ -6,6 +6,125 @@
 	#include "simde/x86/avx512.h"  // SSE intrinsics
 #endif
 
+#include <math.h>
+#include <string.h>
+#include "CvxCompress.hxx"  // cvx_float16, cvx_bfloat16
+
+/*
+ * Load or store samples of a given element type as floats.
+ * Block copy, RMS and the compress/decompress drivers are templated on the element type and use these to convert.
+ */
+static inline __m128 Load4_As_Float(const float* p) {return _mm_loadu_ps(p);}
+static inline __m128 Load4_As_Float(const double* p) {return _mm256_cvtpd_ps(_mm256_loadu_pd(p));}
+static inline float Load1_As_Float(const float* p) {return *p;}
+static inline float Load1_As_Float(const double* p) {return (float)*p;}
+static inline void Store4_From_Float(float* p, __m128 v) {_mm_storeu_ps(p,v);}
+static inline void Store4_From_Float(double* p, __m128 v) {_mm256_storeu_pd(p,_mm256_cvtps_pd(v));}
+static inline void Store1_From_Float(float* p, float v) {*p = v;}
+static inline void Store1_From_Float(double* p, float v) {*p = (double)v;}
+
+/*
+ * Scalar conversions between float and 16 bit floats. Rounding is to nearest even.
+ */
+static inline float Half_To_Float(unsigned short h)
+{
+	unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+	unsigned int exp = (h >> 10) & 0x1F;
+	unsigned int mant = h & 0x3FF;
+	unsigned int bits;
+	if (exp == 0x1F)
+		bits = sign | 0x7F800000 | (mant << 13) | (mant ? 0x00400000 : 0);  // Inf or quiet NaN, same as F16C
+	else if (exp != 0)
+		bits = sign | ((exp + 112) << 23) | (mant << 13);
+	else
+	{
+		float f = (float)mant * 5.9604644775390625e-8f;  // subnormal, mant * 2^-24
+		memcpy(&bits, &f, 4);
+		bits |= sign;
+	}
+	float f;
+	memcpy(&f, &bits, 4);
+	return f;
+}
+
+static inline unsigned short Float_To_Half(float f)
+{
+	unsigned int x;
+	memcpy(&x, &f, 4);
+	unsigned short sign = (x >> 16) & 0x8000;
+	x &= 0x7FFFFFFF;
+	if (x >= 0x7F800000) return sign | (x > 0x7F800000 ? 0x7E00 | ((x >> 13) & 0x3FF) : 0x7C00);  // NaN stays NaN
+	if (x >= 0x477FF000) return sign | 0x7C00;  // rounds to 65520 or more, which is Inf
+	if (x < 0x38800000)
+	{
+		// subnormal half. scaling by 2^24 is exact, lrintf rounds to nearest even.
+		float af;
+		memcpy(&af, &x, 4);
+		return sign | (unsigned short)lrintf(af * 16777216.0f);
+	}
+	unsigned int h = (x - 0x38000000) >> 13;
+	unsigned int rem = x & 0x1FFF;
+	if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;
+	return sign | (unsigned short)h;
+}
+
+static inline float BFloat16_To_Float(unsigned short h)
+{
+	unsigned int bits = (unsigned int)h << 16;
+	float f;
+	memcpy(&f, &bits, 4);
+	return f;
+}
+
+static inline unsigned short Float_To_BFloat16(float f)
+{
+	unsigned int x;
+	memcpy(&x, &f, 4);
+	if ((x & 0x7FFFFFFF) > 0x7F800000) return (x >> 16) | 0x40;  // quiet NaN
+	return (x + 0x7FFF + ((x >> 16) & 1)) >> 16;
+}
+
+/*
+ * Half precision uses F16C when the compiler targets it, scalar code otherwise.
+ * The makefile passes -mf16c along with -mavx on x86_64, so this is only the fallback for other builds.
+ */
+static inline __m128 Load4_As_Float(const cvx_float16* p)
+{
+#ifdef __F16C__
+	return _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)p));
+#else
+	return _mm_setr_ps(Half_To_Float(p[0].bits),Half_To_Float(p[1].bits),Half_To_Float(p[2].bits),Half_To_Float(p[3].bits));
+#endif
+}
+static inline void Store4_From_Float(cvx_float16* p, __m128 v)
+{
+#ifdef __F16C__
+	_mm_storel_epi64((__m128i*)p, _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+#else
+	float f[4];
+	_mm_storeu_ps(f,v);
+	for (int i = 0;  i < 4;  ++i) p[i].bits = Float_To_Half(f[i]);
+#endif
+}
+static inline float Load1_As_Float(const cvx_float16* p) {return Half_To_Float(p->bits);}
+static inline void Store1_From_Float(cvx_float16* p, float v) {p->bits = Float_To_Half(v);}
+
+static inline __m128 Load4_As_Float(const cvx_bfloat16* p)
+{
+	return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), _mm_loadl_epi64((const __m128i*)p)));
+}
+static inline void Store4_From_Float(cvx_bfloat16* p, __m128 v)
+{
+	__m128i x = _mm_castps_si128(v);
+	__m128i lsb = _mm_and_si128(_mm_srli_epi32(x,16), _mm_set1_epi32(1));
+	__m128i r = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, _mm_set1_epi32(0x7FFF)), lsb), 16);
+	__m128i qnan = _mm_or_si128(_mm_srli_epi32(x,16), _mm_set1_epi32(0x40));
+	r = _mm_blendv_epi8(r, qnan, _mm_castps_si128(_mm_cmpunord_ps(v,v)));
+	_mm_storel_epi64((__m128i*)p, _mm_packus_epi32(r,r));
+}
+static inline float Load1_As_Float(const cvx_bfloat16* p) {return BFloat16_To_Float(p->bits);}
+static inline void Store1_From_Float(cvx_bfloat16* p, float v) {p->bits = Float_To_BFloat16(v);}
+
 void Copy_To_Block(
 	float* data,
 	int x0,
@@ -19,6 +138,19 @@ void Copy_To_Block(
 	int by,
 	int bz
 	);
+void Copy_To_Block(
+	double* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz,
+	__m128* work,
+	int bx,
+	int by,
+	int bz
+	);
 void Copy_From_Block(
 	__m128* work,
 	int bx,
@@ -32,5 +164,118 @@ void Copy_From_Block(
 	int ny,
 	int nz
 	);
+void Copy_From_Block(
+	__m128* work,
+	int bx,
+	int by,
+	int bz,
+	double* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz
+	);
+
+void Copy_To_Block(
+	cvx_float16* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz,
+	__m128* work,
+	int bx,
+	int by,
+	int bz
+	);
+void Copy_From_Block(
+	__m128* work,
+	int bx,
+	int by,
+	int bz,
+	cvx_float16* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz
+	);
+void Copy_To_Block(
+	cvx_bfloat16* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz,
+	__m128* work,
+	int bx,
+	int by,
+	int bz
+	);
+void Copy_From_Block(
+	__m128* work,
+	int bx,
+	int by,
+	int bz,
+	cvx_bfloat16* data,
+	int x0,
+	int y0,
+	int z0,
+	int nx,
+	int ny,
+	int nz
+	);
+
+/*
+ * Same as above for volumes whose rows are ldx samples apart and whose slices are ldy rows apart,
+ * e.g. the interior of a padded finite difference array. Only the nx*ny*nz region is read or written.
+ */
+void Copy_To_Block(float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz);
+void Copy_From_Block(__m128* work, int bx, int by, int bz, float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy);
+void Copy_To_Block(double* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz);
+void Copy_From_Block(__m128* work, int bx, int by, int bz, double* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy);
+void Copy_To_Block(cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz);
+void Copy_From_Block(__m128* work, int bx, int by, int bz, cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy);
+void Copy_To_Block(cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy, __m128* work, int bx, int by, int bz);
+void Copy_From_Block(__m128* work, int bx, int by, int bz, cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy);
+
+/*
+ * Same as the packed versions above for volumes stored with z as the fast axis, sample (ix,iy,iz) is data[(ix*ny+iy)*nz+iz].
+ * The block in work has the usual x-fast layout, the transpose happens during the copy.
+ */
+void Copy_To_Block_Z_Fast(float* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz);
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, float* data, int x0, int y0, int z0, int nx, int ny, int nz);
+void Copy_To_Block_Z_Fast(double* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz);
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, double* data, int x0, int y0, int z0, int nx, int ny, int nz);
+void Copy_To_Block_Z_Fast(cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz);
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, cvx_float16* data, int x0, int y0, int z0, int nx, int ny, int nz);
+void Copy_To_Block_Z_Fast(cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, int bx, int by, int bz);
+void Copy_From_Block_Z_Fast(__m128* work, int bx, int by, int bz, cvx_bfloat16* data, int x0, int y0, int z0, int nx, int ny, int nz);
+
+/*
+ * Same as the packed versions above for volumes with nc interleaved components per sample, e.g. complex samples (nc=2).
+ * Component ic of every sample in the block goes to its own bx*by*bz block at work + ic*work_stride/4.
+ */
+void Copy_To_Block_Interleaved(float* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz);
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, float* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz);
+void Copy_To_Block_Interleaved(double* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz);
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, double* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz);
+void Copy_To_Block_Interleaved(cvx_float16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz);
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, cvx_float16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz);
+void Copy_To_Block_Interleaved(cvx_bfloat16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz, __m128* work, long work_stride, int bx, int by, int bz);
+void Copy_From_Block_Interleaved(__m128* work, long work_stride, int bx, int by, int bz, cvx_bfloat16* data, int nc, int x0, int y0, int z0, int nx, int ny, int nz);
+
+/*
+ * Accumulate a block into a float volume instead of overwriting it, avoiding a temporary full-size volume.
+ * Copy_From_Block_Accumulate computes data += alpha * block.
+ * Copy_From_Block_Multiply_Accumulate computes data += src * block, src has the same dimensions and strides as data.
+ */
+void Copy_From_Block_Accumulate(__m128* work, int bx, int by, int bz, float alpha, float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy);
+void Copy_From_Block_Multiply_Accumulate(__m128* work, int bx, int by, int bz, const float* src, float* data, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy);
 
 #endif
@@ -101,9 +101,10 @@ int main(int argc, char* argv[])
     // 					      use_local_RMS,include_block_lengths,
     // 					      compressed,
 
-    float ratio = compressor->Compress(scale, vol,
-				       nz,ny,nx,
-				       bz,by,bx,
+    // volume is trace-major (z fast), blocks are transposed on the fly.
+    float ratio = compressor->Compress_Z_Fast(scale, vol,
+				       nx,ny,nz,
+				       bx,by,bz,
 				       use_local_RMS,
 				       compressed,
 				       compressed_length);
@@ -117,7 +118,7 @@ int main(int argc, char* argv[])
     start = Time::now();
     // **********************  DECOMPRESSING **********************  
     //      compressor->Decompress_Safe(vol2,nz,ny,nx,compressed,compressed_length);
-    compressor->Decompress(vol2, nz,ny,nx, compressed, compressed_length);
+    compressor->Decompress_Z_Fast(vol2, nx,ny,nz, compressed, compressed_length);
 
     stop = Time::now();
     fsec elapsed2 = (stop - start);
@@ -1,4 +1,5 @@
 #include <math.h>
+#include <float.h>
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
@@ -13,6 +14,8 @@
 
 #include "CvxCompress.hxx"
 #include "Wavelet_Transform_Fast.hxx"
+#include "Wavelet_Transform_Lifting.hxx"
+#include "Wavelet_Transform_Int53.hxx"
 #include "Wavelet_Transform_Slow.hxx"  // for comparison in module test
 #include "Block_Copy.hxx"
 #include "Run_Length_Encode_Slow.hxx"  // turns out, it isn't that slow after all
@@ -34,6 +37,7 @@ typedef std::chrono::duration<double> fsec;
 
 CvxCompress::CvxCompress()
 {
+	_use_lifting = false;
 }
 
 CvxCompress::~CvxCompress()
@@ -54,9 +58,9 @@ static int Find_Pow2(int val)
 bool CvxCompress::Is_Valid_Block_Size(int bx, int by, int bz)
 {
 	if (
-		((1 << Find_Pow2(bx)) == bx) && 
-		((1 << Find_Pow2(by)) == by) &&
-		((1 << Find_Pow2(bz)) == bz) &&
+		(bx % Block_Size_Step()) == 0 &&
+		(by % Block_Size_Step()) == 0 &&
+		(bz == 1 || (bz % Block_Size_Step()) == 0) &&
 		(bx >= Min_BX() && bx <= Max_BX()) &&
 		(by >= Min_BY() && by <= Max_BY()) &&
 		(bz == 1 || (bz >= Min_BZ() && bz <= Max_BZ()))
@@ -70,7 +74,18 @@ bool CvxCompress::Is_Valid_Block_Size(int bx, int by, int bz)
 	}
 }
 
-static float Compute_Global_RMS(float* vol, int nx, int ny, int nz)
+/*
+ * Load 4 samples and widen them to double.
+ */
+static inline __m256d Load4_As_Double(const float* p) {return _mm256_cvtps_pd(_mm_loadu_ps(p));}
+static inline __m256d Load4_As_Double(const double* p) {return _mm256_loadu_pd(p);}
+static inline __m256d Load4_As_Double(const cvx_float16* p) {return _mm256_cvtps_pd(Load4_As_Float(p));}
+static inline __m256d Load4_As_Double(const cvx_bfloat16* p) {return _mm256_cvtps_pd(Load4_As_Float(p));}
+template<typename T> static inline double Load1_As_Double(const T* p) {return (double)Load1_As_Float(p);}
+static inline double Load1_As_Double(const double* p) {return *p;}
+
+template<typename T>
+static float Compute_Global_RMS(T* vol, int nx, int ny, int nz)
 {
 	long nn = (long)nx * (long)ny * (long)nz;
 	long _mm_nn = nn >> 2;
@@ -90,8 +105,7 @@ static float Compute_Global_RMS(float* vol, int nx, int ny, int nz)
 		__m256d acc = _mm256_setzero_pd();
 		for (long i = loop_start[iThr];  i < loop_start[iThr+1];  ++i)
 		{
-			__m128 _mm_val = _mm_loadu_ps((float*)(((__m128*)vol)+i));
-			__m256d val = _mm256_cvtps_pd(_mm_val);
+			__m256d val = Load4_As_Double(vol+4*i);
 #ifdef __AVX2__
 			acc = _mm256_fmadd_pd(val,val,acc);
 #else
@@ -108,7 +122,7 @@ static float Compute_Global_RMS(float* vol, int nx, int ny, int nz)
 	}
 	for (long i = loop_start[num_threads]*4;  i < nn;  ++i)
 	{
-		double dval = (double)vol[i];
+		double dval = Load1_As_Double(vol+i);
 		rms += dval * dval;
 	}
 	rms = sqrt(rms/((double)nx*(double)ny*(double)nz));
@@ -116,6 +130,46 @@ static float Compute_Global_RMS(float* vol, int nx, int ny, int nz)
 	return (float)rms;
 }
 
+/*
+ * Global RMS of the nx*ny*nz region of a volume with leading dimensions ldx and ldy.
+ */
+template<typename T>
+static float Compute_Global_RMS(T* vol, int nx, int ny, int nz, int ldx, int ldy)
+{
+	if (ldx == nx && ldy == ny) return Compute_Global_RMS(vol,nx,ny,nz);
+	long nrows = (long)ny * (long)nz;
+	double rms = 0.0;
+#pragma omp parallel for reduction(+:rms) schedule(static)
+	for (long irow = 0;  irow < nrows;  ++irow)
+	{
+		long iz = irow / ny;
+		long iy = irow - iz * ny;
+		T* row = vol + (iz * (long)ldy + iy) * (long)ldx;
+		__m256d acc = _mm256_setzero_pd();
+		int ix = 0;
+		for (;  ix+4 <= nx;  ix+=4)
+		{
+			__m256d val = Load4_As_Double(row+ix);
+#ifdef __AVX2__
+			acc = _mm256_fmadd_pd(val,val,acc);
+#else
+			acc = _mm256_add_pd(acc,_mm256_mul_pd(val,val));
+#endif
+		}
+		double v[4];
+		_mm256_storeu_pd(v,acc);
+		double row_sum = (v[0] + v[1]) + (v[2] + v[3]);
+		for (;  ix < nx;  ++ix)
+		{
+			double dval = Load1_As_Double(row+ix);
+			row_sum += dval * dval;
+		}
+		rms += row_sum;
+	}
+	rms = sqrt(rms/((double)nx*(double)ny*(double)nz));
+	return (float)rms;
+}
+
 static float Compute_Local_RMS(__m256* blk, int bx, int by, int bz)
 {
 	int nn = bz * by * (bx >> 3);
@@ -141,6 +195,58 @@ static float Compute_Local_RMS(__m256* blk, int bx, int by, int bz)
 	return rms;
 }
 
+/*
+ * Largest absolute value in volume. Returns Inf if volume contains NaN or Inf.
+ */
+static float Compute_Max_Abs(float* vol, int nx, int ny, int nz)
+{
+	long nn = (long)nx * (long)ny * (long)nz;
+	float max_abs = 0.0f;
+#pragma omp parallel for reduction(max:max_abs)
+	for (long i = 0;  i < nn;  ++i)
+	{
+		float val = fabsf(vol[i]);
+		if (!(val <= max_abs)) max_abs = isfinite(val) ? val : INFINITY;
+	}
+	return max_abs;
+}
+
+/*
+ * Convert block of floats to integers in place, for the reversible transform.
+ * quant_step > 0 rounds each value to nearest multiple of quant_step.
+ * quant_step = 0 maps the float bit pattern to an integer with the same ordering as the float values,
+ * so neighbouring floats map to neighbouring integers and the mapping is exact.
+ */
+static void Quantize_Block_Int(float* blk, int num, float quant_step)
+{
+	int* iblk = (int*)blk;
+	if (quant_step > 0.0f)
+	{
+		double inv_step = 1.0 / (double)quant_step;
+		for (int i = 0;  i < num;  ++i) iblk[i] = (int)lrint((double)blk[i] * inv_step);
+	}
+	else
+	{
+		for (int i = 0;  i < num;  ++i) iblk[i] = iblk[i] ^ ((iblk[i] >> 31) & 0x7FFFFFFF);
+	}
+}
+
+/*
+ * Inverse of Quantize_Block_Int.
+ */
+static void Dequantize_Block_Int(float* blk, int num, float quant_step)
+{
+	int* iblk = (int*)blk;
+	if (quant_step > 0.0f)
+	{
+		for (int i = 0;  i < num;  ++i) blk[i] = (float)((double)iblk[i] * (double)quant_step);
+	}
+	else
+	{
+		for (int i = 0;  i < num;  ++i) iblk[i] = iblk[i] ^ ((iblk[i] >> 31) & 0x7FFFFFFF);
+	}
+}
+
 #define GET_PRIVATE_POINTERS(work,thread_id) \
 float* priv_work = (float*)(work + thread_id * work_size_one_thread); \
 float* priv_tmp = priv_work + work_wave_transform_buffer_size; \
@@ -151,305 +257,4778 @@ unsigned int* priv_compress_buffer = (unsigned int*)(priv_iBlk + work_blkoff_buf
 
 #define ASSERT_ALIGNMENT(p) assert(((long)p & 31) == 0)
 
-int is_pow2(int val)
+/*
+ * Multiply n samples by fac, n is a multiple of 8.
+ */
+static inline void Scale_Block(float* blk, int n, float fac)
 {
-        if (val <= 1)
-        {
-                return 0;
-        }
-        else
-        {
-                int shift_val = val >> 1;
-                int num_shifts = 0;
-                while (shift_val != 0)
-                {
-                        ++num_shifts;
-                        shift_val = shift_val >> 1;
-                };
-                return (val == (1 << num_shifts)) ? -1 : 0;
-        }
+	__m256 vfac = _mm256_set1_ps(fac);
+	for (int i = 0;  i < n;  i+=8) _mm256_storeu_ps(blk+i, _mm256_mul_ps(_mm256_loadu_ps(blk+i),vfac));
 }
 
-float CvxCompress::Compress(
-	float scale,
-	float* vol,
-	int nx,
-	int ny,
-	int nz,
+/*
+ * True if blocks of bx*by*bz samples are transformed with the lifting engine. Lifting only beats the convolution kernels
+ * from 64^3 samples up, smaller blocks spend more time on the end cases of its short lines than it saves in multiply-adds.
+ */
+static inline bool Use_Lifting(CvxCompress& cvx, int bx, int by, int bz)
+{
+	return cvx.Get_Use_Lifting() && (long)bx * (long)by * (long)bz >= 262144;
+}
+
+/*
+ * Forward transform one block in place, see Encode_Block for the block layout.
+ */
+static void Forward_Transform_Block(
+	CvxCompress& cvx,
+	float* priv_work,
+	float* priv_tmp,
 	int bx,
 	int by,
 	int bz,
-	unsigned int* compressed,
-	long& compressed_length 
+	int bt,
+	int nc
 	)
 {
-	bool use_local_RMS = false;
-	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,compressed_length);
+	for (int it = 0;  it < bt*nc;  ++it)
+	{
+		float* priv_snap = priv_work + it*bx*by*bz;
+		if (Use_Lifting(cvx,bx,by,bz))
+			Wavelet_Transform_Lifting_Forward((__m256*)priv_snap,bx,by,bz);
+		else
+			Wavelet_Transform_Fast_Forward((__m256*)priv_snap,(__m256*)priv_tmp,bx,by,bz);
+	}
+	if (bt > 1)
+		for (int ic = 0;  ic < nc;  ++ic)
+			Wavelet_Transform_Fast_Forward_T((__m256*)(priv_work+ic*bt*bx*by*bz),(__m256*)priv_tmp,bx*by*bz,bt);
 }
 
-float CvxCompress::Compress(
-	float scale,
-	float* vol,
-	int nx,
-	int ny,
-	int nz,
+/*
+ * Inverse of Forward_Transform_Block.
+ */
+static void Inverse_Transform_Block(
+	CvxCompress& cvx,
+	float* priv_work,
+	float* priv_tmp,
 	int bx,
 	int by,
 	int bz,
-	bool use_local_RMS,
-	unsigned int* compressed,
-	long& compressed_length 
+	int bt,
+	int nc
 	)
 {
-	int num_threads;
-#pragma omp parallel
+	if (bt > 1)
+		for (int ic = 0;  ic < nc;  ++ic)
+			Wavelet_Transform_Fast_Inverse_T((__m256*)(priv_work+ic*bt*bx*by*bz),(__m256*)priv_tmp,bx*by*bz,bt);
+	for (int it = 0;  it < bt*nc;  ++it)
 	{
-		num_threads = omp_get_num_threads();
+		float* priv_snap = priv_work + it*bx*by*bz;
+		if (Use_Lifting(cvx,bx,by,bz))
+			Wavelet_Transform_Lifting_Inverse((__m256*)priv_snap,bx,by,bz);
+		else
+			Wavelet_Transform_Fast_Inverse((__m256*)priv_snap,(__m256*)priv_tmp,bx,by,bz);
 	}
-	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+	//printf("...Wavelet_Transform_Fast_Inverse done\n");  fflush(stdout);
 }
 
-float CvxCompress::Compress(
+/*
+ * Quantize and run length encode the wavelet coefficients of one block, see Encode_Block.
+ * blksize is the number of coefficients in the block, the nm components with their own factor are blksize/nm coefficients each.
+ * Components with their own factor are scaled in place before they are run length encoded with a factor of 1.
+ * Returns the number of bytes written to priv_compressed.
+ */
+static int Encode_Coefficients(
 	float scale,
-	float* vol,
-	int nx,
-	int ny,
-	int nz,
+	bool use_local_RMS,
+	float* priv_work,
+	unsigned long* priv_compressed,
 	int bx,
 	int by,
-	int bz,
-	unsigned int* compressed,
-	int num_threads,
-	long& compressed_length 
+	int blksize,
+	int nm,
+	float* mulfac,
+	bool& uncompressed
 	)
 {
-	bool use_local_RMS = false;
-	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+	int bytepos = 0;
+	int mblksize = blksize / nm;
+	if (use_local_RMS)
+	{
+		for (int im = 0;  im < nm;  ++im)
+		{
+			float local_RMS = Compute_Local_RMS((__m256*)(priv_work+im*mblksize),bx,by,mblksize/(bx*by));
+			mulfac[im] = local_RMS != 0.0f ? 1.0f / (local_RMS * scale) : 1.0f;
+		}
+	}
+	if (nm == 1)
+	{
+		Run_Length_Encode_Slow(mulfac[0],priv_work,blksize,priv_compressed,bytepos);
+	}
+	else
+	{
+		for (int im = 0;  im < nm;  ++im) Scale_Block(priv_work+im*mblksize,mblksize,mulfac[im]);
+		Run_Length_Encode_Slow(1.0f,priv_work,blksize,priv_compressed,bytepos);
+	}
+	//printf("Compressed block is %d bytes (ratio=%.2f:1)\n",bytepos,(double)(4*blksize)/(double)bytepos);
+	//Run_Length_Encode_Fast(mulfac,priv_work,blksize,priv_compressed,bytepos,error);
+	uncompressed = (bytepos > (4*blksize));
+	if (uncompressed)
+	{
+		memcpy(priv_compressed,priv_work,sizeof(float)*blksize);
+		bytepos = sizeof(float)*blksize;
+	}
+	return bytepos;
 }
 
+/*
+ * Decode the wavelet coefficients of one block into priv_work. Inverse of Encode_Coefficients.
+ */
+static void Decode_Coefficients(
+	bool uncompressed,
+	float* priv_work,
+	unsigned long* priv_compressed,
+	int blksize,
+	int nm,
+	const float* mulfac
+	)
+{
+	if (uncompressed)
+	{
+		//printf("  block is uncompressed!\n");
+		memcpy(priv_work,priv_compressed,sizeof(float)*blksize);
+	}
+	else
+	{
+		Run_Length_Decode_Slow(nm == 1 ? mulfac[0] : 1.0f,priv_work,blksize,priv_compressed);
+		//printf("...Run_Length_Decode_Slow done\n");  fflush(stdout);
+	}
+	if (nm > 1)
+	{
+		int mblksize = blksize / nm;
+		for (int im = 0;  im < nm;  ++im) Scale_Block(priv_work+im*mblksize,mblksize,1.0f/mulfac[im]);
+	}
+}
 
-float CvxCompress::Compress(
+/*
+ * Transform and encode one block that has been copied into priv_work.
+ * 4D blocks are bt consecutive bx*by*bz blocks, each is transformed in space before the transform along time.
+ * Blocks of volumes with nc components hold the nc component blocks one after the other. They are transformed
+ * separately and run length encoded together, so they need a single entry in the block index.
+ * mulfac holds nm multiplication factors, nm is 1 if all components share one factor and nc otherwise.
+ * mulfac must hold the global multiplication factors on entry, they are replaced by the block's own factors when use_local_RMS is set.
+ * If the encoded block is larger than the raw block, the transformed block is stored as is and uncompressed is set.
+ * priv_compressed must have room for 5/4 of the raw block size.
+ * Returns the number of bytes written to priv_compressed.
+ */
+static int Encode_Block(
+	CvxCompress& cvx,
 	float scale,
-	float* vol,
-	int nx,
-	int ny,
-	int nz,
+	bool reversible,
+	float quant_step,
+	bool use_local_RMS,
+	float* priv_work,
+	float* priv_tmp,
+	unsigned long* priv_compressed,
 	int bx,
 	int by,
 	int bz,
-	bool use_local_RMS,
-	unsigned int* compressed,
-	int num_threads,
-	long& compressed_length 
+	int bt,
+	int nc,
+	int nm,
+	float* mulfac,
+	bool& uncompressed
 	)
 {
-	assert(bx >= CvxCompress::Min_BX() && bx <= CvxCompress::Max_BX() && is_pow2(bx));
-	assert(by >= CvxCompress::Min_BY() && by <= CvxCompress::Max_BY() && is_pow2(by));
-	assert(bz == 1 || (bz >= CvxCompress::Min_BZ() && bz <= CvxCompress::Max_BZ() && is_pow2(bz)));
-	float global_rms = use_local_RMS ? 1.0f : Compute_Global_RMS(vol,nx,ny,nz);
-
-	omp_set_num_threads(num_threads);
-
-#define MAX(a,b) (a>b?a:b)
-	int max_bs = MAX(bx,MAX(by,bz));
-#undef MAX
-	int priv_blkoff_len = 262144 / (bx*by*bz);
-	priv_blkoff_len = priv_blkoff_len > 1 ? priv_blkoff_len : 1;
-	int work_blkoff_buffer_size = priv_blkoff_len + 2;
-	int work_compress_buffer_size = priv_blkoff_len*bx*by*bz + ((bx*by*bz)>>2);
-	int work_wave_transform_buffer_size = bx*by*bz;
-	int work_wave_transform_tmp_buffer_size = max_bs*8;
-	int work_size_one_thread = 2*work_blkoff_buffer_size + work_compress_buffer_size + work_wave_transform_buffer_size + work_wave_transform_tmp_buffer_size;
-	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
-	int work_size = work_size_one_thread * num_threads;
-	if (work_size_one_thread != (work_size / num_threads)) {printf("Error! work buffer too large!\n"); exit(-1);}
-	float* work;
-	posix_memalign((void**)&work, 64, sizeof(float)*work_size);
-#pragma omp parallel for schedule(static,1)
-	for (int iThread = 0;  iThread < num_threads;  ++iThread)
+	int blksize = bx*by*bz*bt*nc;
+	if (!reversible)
 	{
-		int thread_id = omp_get_thread_num();
-		GET_PRIVATE_POINTERS(work,thread_id);
-		ASSERT_ALIGNMENT(priv_work);
-		ASSERT_ALIGNMENT(priv_tmp);
-		int* p = (int*)(work + thread_id * work_size_one_thread);
-		for (int i = 0;  i < work_size_one_thread;  ++i) p[i] = 0;
+		Forward_Transform_Block(cvx,priv_work,priv_tmp,bx,by,bz,bt,nc);
+		return Encode_Coefficients(scale,use_local_RMS,priv_work,priv_compressed,bx,by,blksize,nm,mulfac,uncompressed);
 	}
-
-	int nbx = (nx+bx-1)/bx;
-	int nby = (ny+by-1)/by;
-	int nbz = (nz+bz-1)/bz;
-	int nnn = nbx*nby*nbz;
-	
-	compressed[0] = nx;
-	compressed[1] = ny;
-	compressed[2] = nz;
-	compressed[3] = bx;
-	compressed[4] = by;
-	compressed[5] = bz;
-	
-	float glob_mulfac = global_rms != 0.0f ? 1.0f / (global_rms * scale) : 1.0f;
-	// Some combinations of scale and global_rms lead to Inf when global_rms is very small
-	// breaking decompression.
-	glob_mulfac = !isfinite(glob_mulfac) ? 1.0f : glob_mulfac;
-	compressed[6] = *((unsigned int*)&glob_mulfac);
-	// printf("nx=%d, ny=%d, nz=%d, bx=%d, by=%d, bz=%d, mulfac=%e\n",nx,ny,nz,bx,by,bz,glob_mulfac);
-
-	// flags:
-	// 1 -> use local RMS (global RMS otherwise)
-	compressed[7] = use_local_RMS ? 1 : 0;
-
-	long* glob_blkoffs = (long*)(compressed+8);  // no need to initialize
-
-	float* blkmulfac = 0L;
-	unsigned int* bytes;
-	if (use_local_RMS)
+	assert(bt == 1 && nc == 1);
+	int bytepos = 0;
+	Quantize_Block_Int(priv_work,blksize,quant_step);
+	Wavelet_Transform_Int53_Forward((int*)priv_work,(int*)priv_tmp,bx,by,bz);
+	Run_Length_Encode_Int((int*)priv_work,blksize,priv_compressed,bytepos);
+	uncompressed = (bytepos > (4*blksize));
+	if (uncompressed)
 	{
-		blkmulfac = (float*)(glob_blkoffs+nnn);
-		bytes = (unsigned int*)(blkmulfac+nnn);
+		memcpy(priv_compressed,priv_work,sizeof(float)*blksize);
+		bytepos = sizeof(float)*blksize;
 	}
-	else
+	return bytepos;
+}
+
+/*
+ * Decode and inverse transform one block into priv_work. Inverse of Encode_Block.
+ * For reversible streams mulfac is the quantization step from the header.
+ */
+static void Decode_Block(
+	CvxCompress& cvx,
+	bool reversible,
+	bool uncompressed,
+	float* priv_work,
+	float* priv_tmp,
+	unsigned long* priv_compressed,
+	int bx,
+	int by,
+	int bz,
+	int bt,
+	int nc,
+	int nm,
+	const float* mulfac
+	)
+{
+	int blksize = bx*by*bz*bt*nc;
+	if (reversible)
 	{
-		blkmulfac = 0L;
-		bytes = (unsigned int*)(glob_blkoffs+nnn);
+		assert(bt == 1 && nc == 1);
+		if (uncompressed)
+			memcpy(priv_work,priv_compressed,sizeof(int)*blksize);
+		else
+			Run_Length_Decode_Int((int*)priv_work,blksize,priv_compressed);
+		Wavelet_Transform_Int53_Inverse((int*)priv_work,(int*)priv_tmp,bx,by,bz);
+		Dequantize_Block_Int(priv_work,blksize,mulfac[0]);
+		return;
 	}
-	long byte_offset = 0l;
+	Decode_Coefficients(uncompressed,priv_work,priv_compressed,blksize,nm,mulfac);
+	Inverse_Transform_Block(cvx,priv_work,priv_tmp,bx,by,bz,bt,nc);
+}
 
-#pragma omp parallel for schedule(dynamic)
-	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+/*
+ * Global RMS of each of nvol volumes in a single parallel region.
+ * Rows of each volume are ldx samples apart and slices ldy rows apart.
+ */
+template<typename T>
+static void Compute_Global_RMS_Batch(T* const* vols, int nvol, int nx, int ny, int nz, int ldx, int ldy, float* rms)
+{
+	long nrows = (long)ny * (long)nz;
+	int num_threads;
+#pragma omp parallel
 	{
-		long iiz = iBlk / (nbx*nby);
-		long iix = iBlk - iiz*nbx*nby;
-		long iiy = iix / nbx;
-		iix = iix - iiy*nbx;
-
-		int x0 = iix*bx;
-		int y0 = iiy*by;
-		int z0 = iiz*bz;
-
-		//printf("iBlk=%d, x0=%d, y0=%d, z0=%d\n",iBlk,x0,y0,z0);
-
-		int thread_id = omp_get_thread_num();
-		GET_PRIVATE_POINTERS(work,thread_id);
-
-		priv_iBlk[*priv_blkstore_idx] = iBlk;
-		int blkoff = priv_blkoff[*priv_blkstore_idx];
-		unsigned long* priv_compressed = (unsigned long*)(((char*)priv_compress_buffer) + blkoff);
-
-		Copy_To_Block(vol,x0,y0,z0,nx,ny,nz,(__m128*)priv_work,bx,by,bz);
-		Wavelet_Transform_Fast_Forward((__m256*)priv_work,(__m256*)priv_tmp,bx,by,bz);
-		int bytepos = 0, error = 0;
-		float mulfac = glob_mulfac;
-		if (use_local_RMS)
-		{
-			float local_RMS = Compute_Local_RMS((__m256*)priv_work,bx,by,bz);
-			mulfac = local_RMS != 0.0f ? 1.0f / (local_RMS * scale) : 1.0f;
-			blkmulfac[iBlk] = mulfac;
-		}
-		Run_Length_Encode_Slow(mulfac,priv_work,bx*by*bz,priv_compressed,bytepos);
-		error = (bytepos > (4*bx*by*bz)) ? -1 : 0;
-		//printf("Compressed block is %d bytes (ratio=%.2f:1, error = %d)\n",bytepos,(double)(4*bx*by*bz)/(double)bytepos,error);
-		//Run_Length_Encode_Fast(mulfac,priv_work,bx*by*bz,priv_compressed,bytepos,error);
-
-		++(*priv_blkstore_idx);
-		if (error)
+		num_threads = omp_get_num_threads();
+	}
+	double* partial = new double[(long)num_threads*nvol];
+	for (long i = 0;  i < (long)num_threads*nvol;  ++i) partial[i] = 0.0;
+#pragma omp parallel for schedule(static)
+	for (long ivrow = 0;  ivrow < nvol*nrows;  ++ivrow)
+	{
+		int ivol = ivrow / nrows;
+		long irow = ivrow - ivol * nrows;
+		long iz = irow / ny;
+		long iy = irow - iz * ny;
+		T* row = vols[ivol] + (iz * (long)ldy + iy) * (long)ldx;
+		__m256d acc = _mm256_setzero_pd();
+		int ix = 0;
+		for (;  ix+4 <= nx;  ix+=4)
 		{
-			priv_blkoff[(*priv_blkstore_idx)-1] |= -2147483648;
-			priv_blkoff[*priv_blkstore_idx] = blkoff+sizeof(float)*bx*by*bz;
-			memcpy(priv_compressed,priv_work,sizeof(float)*bx*by*bz);
+			__m256d val = Load4_As_Double(row+ix);
+#ifdef __AVX2__
+			acc = _mm256_fmadd_pd(val,val,acc);
+#else
+			acc = _mm256_add_pd(acc,_mm256_mul_pd(val,val));
+#endif
 		}
-		else
+		double v[4];
+		_mm256_storeu_pd(v,acc);
+		double row_sum = (v[0] + v[1]) + (v[2] + v[3]);
+		for (;  ix < nx;  ++ix)
 		{
-			priv_blkoff[*priv_blkstore_idx] = blkoff + bytepos;
+			double dval = Load1_As_Double(row+ix);
+			row_sum += dval * dval;
 		}
-		if (*priv_blkstore_idx >= priv_blkoff_len)
+		partial[(long)omp_get_thread_num()*nvol+ivol] += row_sum;
+	}
+	for (int ivol = 0;  ivol < nvol;  ++ivol)
+	{
+		double sum = 0.0;
+		for (int iThr = 0;  iThr < num_threads;  ++iThr) sum += partial[(long)iThr*nvol+ivol];
+		rms[ivol] = (float)sqrt(sum/((double)nx*(double)ny*(double)nz));
+	}
+	delete [] partial;
+}
+
+/*
+ * Global RMS of every component of a packed volume with nc interleaved components.
+ */
+template<typename T>
+static void Compute_Global_RMS_Components(T* vol, int nc, int nx, int ny, int nz, float* rms)
+{
+	long nrows = (long)ny * (long)nz;
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	double* partial = new double[(long)num_threads*nc];
+	for (long i = 0;  i < (long)num_threads*nc;  ++i) partial[i] = 0.0;
+#pragma omp parallel for schedule(static)
+	for (long irow = 0;  irow < nrows;  ++irow)
+	{
+		T* row = vol + irow * (long)nx * (long)nc;
+		double* thr_partial = partial + (long)omp_get_thread_num()*nc;
+		for (int ix = 0;  ix < nx;  ++ix)
 		{
-			// copy compressed blocks from private area to global area.
-			int priv_blklen = priv_blkoff[*priv_blkstore_idx];
-			char* glob_dst = 0L;
-#pragma omp critical
-			{
-				glob_dst = ((char*)bytes) + byte_offset;
-				byte_offset += (long)priv_blklen;
-			}
-			//printf("MEMCPY :: GLOB byte_offset=%ld, priv_blkstore_idx=%d, priv_blklen=%d\n",byte_offset,*priv_blkstore_idx,priv_blklen);
-			for (int i = 0;  i < *priv_blkstore_idx;  ++i) 
+			for (int ic = 0;  ic < nc;  ++ic)
 			{
-				int dst_iBlk = priv_iBlk[i];
-				int blkoff = priv_blkoff[i];
-				bool uncompressed = (blkoff & 0x80000000) ? true : false;
-				blkoff = blkoff & 0x7FFFFFFF;
-				long new_glob_blkoff = (glob_dst + blkoff) - (char*)bytes;
-				new_glob_blkoff = uncompressed ? (new_glob_blkoff | 0x8000000000000000) : new_glob_blkoff;
-				glob_blkoffs[dst_iBlk] = new_glob_blkoff;
-				//printf("  uncompressed=%s, blkoff=%ld, glob_blkoffs[%d]=%ld\n",uncompressed?"true":"false",blkoff,dst_iBlk,glob_blkoffs[dst_iBlk]);
+				double dval = Load1_As_Double(row+(long)ix*nc+ic);
+				thr_partial[ic] += dval * dval;
 			}
-			memcpy(glob_dst,priv_compress_buffer,priv_blklen);
-			*priv_blkstore_idx = 0;
-			priv_blkoff[0] = 0;
 		}
 	}
-	for (int thread_id = 0;  thread_id < num_threads;  ++thread_id)
+	for (int ic = 0;  ic < nc;  ++ic)
 	{
-		GET_PRIVATE_POINTERS(work,thread_id);
-		if (*priv_blkstore_idx >= 1)
-		{
-			// copy compressed blocks from private area to global area.
-			int priv_blklen = priv_blkoff[*priv_blkstore_idx];
-                        char* glob_dst = 0L;
-                        {
-                                glob_dst = ((char*)bytes) + byte_offset;
-                                byte_offset += (long)priv_blklen;
-                        }
-                        //printf("MEMCPY :: GLOB byte_offset=%ld, priv_blkstore_idx=%d, priv_blklen=%d\n",byte_offset,*priv_blkstore_idx,priv_blklen);
-                        for (int i = 0;  i < *priv_blkstore_idx;  ++i)
-                        {
-                                int dst_iBlk = priv_iBlk[i];
-                                int blkoff = priv_blkoff[i];
-                                bool uncompressed = (blkoff & 0x80000000) ? true : false;
-                                blkoff = blkoff & 0x7FFFFFFF;
-                                long new_glob_blkoff = (glob_dst + blkoff) - (char*)bytes;
-                                new_glob_blkoff = uncompressed ? (new_glob_blkoff | 0x8000000000000000) : new_glob_blkoff;
-                                glob_blkoffs[dst_iBlk] = new_glob_blkoff;
-                                //printf("  uncompressed=%s, blkoff=%ld, glob_blkoffs[%d]=%ld\n",uncompressed?"true":"false",blkoff,dst_iBlk,glob_blkoffs[dst_iBlk]);
-                        }
-                        memcpy(glob_dst,priv_compress_buffer,priv_blklen);
-                        *priv_blkstore_idx = 0;
-                        priv_blkoff[0] = 0;
-		}
-	}
-	compressed_length = 32 + 8*nnn + byte_offset + 7;
-	if (use_local_RMS) compressed_length += 4*nnn;
+		double sum = 0.0;
+		for (int iThr = 0;  iThr < num_threads;  ++iThr) sum += partial[(long)iThr*nc+ic];
+		rms[ic] = (float)sqrt(sum/((double)nx*(double)ny*(double)nz));
+	}
+	delete [] partial;
+}
 
-	free(work);
-	double ratio = ((double)nx * (double)ny * (double)nz * (double)sizeof(float)) / (double)compressed_length;
-	return (float)ratio;
+/*
+ * Copy the blocks buffered in a thread's private area to the global area of the stream they belong to.
+ */
+static void Flush_Private_Blocks(
+	int* priv_blkstore_idx,
+	int* priv_blkoff,
+	int* priv_iBlk,
+	unsigned int* priv_compress_buffer,
+	unsigned int* bytes,
+	long* glob_blkoffs,
+	long& byte_offset
+	)
+{
+	int priv_blklen = priv_blkoff[*priv_blkstore_idx];
+	char* glob_dst = 0L;
+#pragma omp critical
+	{
+		glob_dst = ((char*)bytes) + byte_offset;
+		byte_offset += (long)priv_blklen;
+	}
+	//printf("MEMCPY :: GLOB byte_offset=%ld, priv_blkstore_idx=%d, priv_blklen=%d\n",byte_offset,*priv_blkstore_idx,priv_blklen);
+	for (int i = 0;  i < *priv_blkstore_idx;  ++i) 
+	{
+		int dst_iBlk = priv_iBlk[i];
+		int blkoff = priv_blkoff[i];
+		bool uncompressed = (blkoff & 0x80000000) ? true : false;
+		blkoff = blkoff & 0x7FFFFFFF;
+		long new_glob_blkoff = (glob_dst + blkoff) - (char*)bytes;
+		new_glob_blkoff = uncompressed ? (new_glob_blkoff | 0x8000000000000000) : new_glob_blkoff;
+		glob_blkoffs[dst_iBlk] = new_glob_blkoff;
+		//printf("  uncompressed=%s, blkoff=%ld, glob_blkoffs[%d]=%ld\n",uncompressed?"true":"false",blkoff,dst_iBlk,glob_blkoffs[dst_iBlk]);
+	}
+	memcpy(glob_dst,priv_compress_buffer,priv_blklen);
+	*priv_blkstore_idx = 0;
+	priv_blkoff[0] = 0;
 }
 
-float* CvxCompress::Decompress(
-	int& nx,
-	int& ny,
-	int& nz,
-	unsigned int* compressed,
-	long compressed_length 
+/*
+ * Parse the layout words of a stream header. Returns the number of header words, i.e. where the block index starts.
+ */
+static int Stream_Header_Words(
+	const unsigned int* compressed,
+	int& nt,
+	int& bt,
+	int& nc,
+	int& nm
 	)
 {
-	nx = ((int*)compressed)[0];
-	ny = ((int*)compressed)[1];
-	nz = ((int*)compressed)[2];
-	float* vol;
-	posix_memalign((void**)&vol, 64, (long)nx*(long)ny*(long)nz*(long)sizeof(float));
-	Decompress(vol, nx, ny, nz, compressed, compressed_length);
-	return vol;
+	int flags = compressed[7];
+	bool four_d = (flags & 16) ? true : false;
+	nt = four_d ? compressed[8] : 1;
+	bt = four_d ? compressed[9] : 1;
+	int comp_word = 8 + (four_d ? 2 : 0);
+	int mulfac_word = comp_word + ((flags & 32) ? 2 : 0) + ((flags & 512) ? 2 : 0) + ((flags & 1024) ? 2 : 0);
+	nc = (flags & 32) ? compressed[comp_word] : 1;
+	nm = (flags & 64) ? nc : 1;
+	return mulfac_word + (nm > 1 ? (nm+1) & ~1 : 0);
 }
 
-void CvxCompress::Decompress(
-	float *vol,
-	int nx,
+/*
+ * Number of blocks in a stream.
+ */
+static long Stream_Num_Blocks(const unsigned int* compressed)
+{
+	int nt, bt, nc, nm;
+	Stream_Header_Words(compressed,nt,bt,nc,nm);
+	int nx = compressed[0], ny = compressed[1], nz = compressed[2];
+	int bx = compressed[3], by = compressed[4], bz = compressed[5];
+	return (long)((nx+bx-1)/bx) * (long)((ny+by-1)/by) * (long)((nz+bz-1)/bz) * (long)((nt+bt-1)/bt);
+}
+
+/*
+ * Value that blocks left out by a Cell_Exclusion (flag 1024) decode to, 0 for other streams.
+ */
+static float Stream_Fill_Value(const unsigned int* compressed)
+{
+	int flags = compressed[7];
+	if (!(flags & 1024)) return 0.0f;
+	float fill;
+	memcpy(&fill, compressed + 8 + ((flags & 16) ? 2 : 0) + ((flags & 32) ? 2 : 0), sizeof(float));
+	return fill;
+}
+
+/*
+ * The block index follows the header. By default it holds the 8 byte offset of every block into the encoded bytes.
+ * A compact index (flag 128) splits the blocks into groups of BLOCK_INDEX_GROUP_SIZE, it holds an 8 byte base for
+ * every group followed by a 4 byte offset from its group's base for every block, rounded up to an even count.
+ * Either way the top bit of a block's offset flags an uncompressed block. Blocks that were left out have offset -1,
+ * 0xFFFFFFFF in the compact index.
+ * Fixed size streams (flag 256) have no index, the 8 bytes after the header hold the slot size, see Compress_Fixed_Volume.
+ */
+#define BLOCK_INDEX_GROUP_SIZE 64
+
+/*
+ * Size of the block index of a stream with nnn blocks in bytes.
+ */
+static long Block_Index_Bytes(long nnn, bool compact)
+{
+	if (!compact) return 8*nnn;
+	long ngroups = (nnn + BLOCK_INDEX_GROUP_SIZE - 1) / BLOCK_INDEX_GROUP_SIZE;
+	return 8*ngroups + 4*((nnn+1) & ~1l);
+}
+
+/*
+ * Offset of block iBlk, with the uncompressed flag in the top bit like the 8 byte index has it.
+ */
+static inline long Get_Block_Offset(const unsigned int* index, long nnn, bool compact, long iBlk)
+{
+	if (!compact) return ((const long*)index)[iBlk];
+	long ngroups = (nnn + BLOCK_INDEX_GROUP_SIZE - 1) / BLOCK_INDEX_GROUP_SIZE;
+	unsigned int rel = index[2*ngroups+iBlk];
+	if (rel == 0xFFFFFFFF) return -1l;
+	long blkoff = ((const long*)index)[iBlk/BLOCK_INDEX_GROUP_SIZE] + (long)(rel & 0x7FFFFFFF);
+	return (rel & 0x80000000) ? (blkoff | 0x8000000000000000) : blkoff;
+}
+
+/*
+ * Bytes a new stream with nnn blocks reserves for its block index, the compact index unless it would not be any smaller.
+ */
+static long Reserved_Index_Bytes(long nnn)
+{
+	long compact_bytes = Block_Index_Bytes(nnn,true);
+	long wide_bytes = Block_Index_Bytes(nnn,false);
+	return compact_bytes < wide_bytes ? compact_bytes : wide_bytes;
+}
+
+/*
+ * Write the block index of a finished stream from the 8 byte offsets of its blocks, which the compressor keeps outside the stream.
+ * The stream was laid out with Reserved_Index_Bytes(nnn) bytes for the index and compressed_length counts those.
+ * Streams with a group whose blocks are spread over 2GB or more get the 8 byte index, which moves the rest of the stream up
+ * by the difference, so the output buffer must have room for the 8 byte index.
+ */
+static void Write_Block_Index(
+	unsigned int* compressed,
+	const long* glob_blkoffs,
+	long& compressed_length
+	)
+{
+	int nt, bt, nc, nm;
+	int hdr_words = Stream_Header_Words(compressed,nt,bt,nc,nm);
+	long nnn = Stream_Num_Blocks(compressed);
+	long wide_bytes = Block_Index_Bytes(nnn,false);
+	long reserved_bytes = Reserved_Index_Bytes(nnn);
+	char* index = (char*)(compressed+hdr_words);
+	bool compact = reserved_bytes < wide_bytes;
+	long ngroups = (nnn + BLOCK_INDEX_GROUP_SIZE - 1) / BLOCK_INDEX_GROUP_SIZE;
+	long* group_base = (long*)index;
+	for (long igroup = 0;  igroup < ngroups && compact;  ++igroup)
+	{
+		// blocks are flushed by several threads, so the first block of a group is not always the first one in the stream.
+		long lo = 0x7FFFFFFFFFFFFFFF, hi = 0;
+		for (long iBlk = igroup*BLOCK_INDEX_GROUP_SIZE;  iBlk < (igroup+1)*BLOCK_INDEX_GROUP_SIZE && iBlk < nnn;  ++iBlk)
+		{
+			if (glob_blkoffs[iBlk] == -1l) continue;
+			long blkoff = glob_blkoffs[iBlk] & 0x7FFFFFFFFFFFFFFF;
+			lo = blkoff < lo ? blkoff : lo;
+			hi = blkoff > hi ? blkoff : hi;
+		}
+		// 0xFFFFFFFF is reserved for blocks that were left out.
+		compact = hi - lo < 0x7FFFFFFF || hi < lo;
+		group_base[igroup] = hi >= lo ? lo : 0;
+	}
+	if (!compact)
+	{
+		if (reserved_bytes < wide_bytes)
+		{
+			// local multiplication factors, encoded blocks and the padding at the end.
+			long tail = compressed_length - 4*hdr_words - reserved_bytes;
+			memmove(index+wide_bytes,index+reserved_bytes,tail);
+			compressed_length += wide_bytes - reserved_bytes;
+		}
+		memcpy(index,glob_blkoffs,wide_bytes);
+		return;
+	}
+	unsigned int* rel = (unsigned int*)(index + 8*ngroups);
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		long blkoff = glob_blkoffs[iBlk];
+		if (blkoff == -1l)
+		{
+			rel[iBlk] = 0xFFFFFFFF;
+			continue;
+		}
+		rel[iBlk] = (unsigned int)((blkoff & 0x7FFFFFFFFFFFFFFF) - group_base[iBlk/BLOCK_INDEX_GROUP_SIZE]);
+		if (blkoff & 0x8000000000000000) rel[iBlk] |= 0x80000000;
+	}
+	if (nnn & 1) rel[nnn] = 0;
+	compressed[7] |= 128;
+}
+
+/*
+ * Find block iBlk of a stream. Sets uncompressed and points mulfac at the multiplication factors of the block,
+ * which are the block's own factors for local RMS streams and the global factors otherwise.
+ * Returns the encoded bytes of the block, or 0L for a block that was left out, see Stream_Fill_Value.
+ */
+static unsigned long* Locate_Block(
+	unsigned int* compressed,
+	long iBlk,
+	bool& uncompressed,
+	const float*& mulfac
+	)
+{
+	int nt, bt, nc, nm;
+	int hdr_words = Stream_Header_Words(compressed,nt,bt,nc,nm);
+	long nnn = Stream_Num_Blocks(compressed);
+	bool use_local_RMS = (compressed[7] & 1) ? true : false;
+	bool compact = (compressed[7] & 128) ? true : false;
+	const unsigned int* index = compressed+hdr_words;
+	if (compressed[7] & 256)
+	{
+		char* slot = (char*)(index+2) + iBlk * *((const long*)index);
+		uncompressed = false;
+		mulfac = (const float*)slot;
+		return (unsigned long*)(slot+4);
+	}
+	float* blkmulfac = (float*)((char*)index + Block_Index_Bytes(nnn,compact));
+	char* bytes = (char*)(use_local_RMS ? (void*)(blkmulfac+nnn*nm) : (void*)blkmulfac);
+	long blkoff = Get_Block_Offset(index,nnn,compact,iBlk);
+	uncompressed = (blkoff & 0x8000000000000000) ? true : false;
+	blkoff = blkoff & 0x7FFFFFFFFFFFFFFF;
+	if (blkoff == 0x7FFFFFFFFFFFFFFF) return 0L;
+	if (use_local_RMS)
+		mulfac = blkmulfac + iBlk*nm;
+	else
+		mulfac = (const float*)(compressed + (nm > 1 ? hdr_words - ((nm+1) & ~1) : 6));
+	return (unsigned long*)(bytes + blkoff);
+}
+
+/*
+ * Linear combination of nin streams with the same shape, block grid and layout.
+ * Compress_Volumes evaluates it block by block on the decoded wavelet coefficients, which is exact up to quantization
+ * since the transforms are linear, instead of gathering and transforming volumes.
+ */
+struct Compressed_Sum
+{
+	int nin;
+	unsigned int* const* streams;
+	const float* weights;
+};
+
+/*
+ * Decode block iBlk of every stream of sum and combine the coefficients into priv_work.
+ * priv_in is scratch space for blksize coefficients.
+ */
+static void Sum_Block_Coefficients(
+	const Compressed_Sum& sum,
+	long iBlk,
+	float* priv_work,
+	float* priv_in,
+	int blksize,
+	int nm
+	)
+{
+	for (int in = 0;  in < sum.nin;  ++in)
+	{
+		bool uncompressed;
+		const float* mulfac;
+		unsigned long* priv_compressed = Locate_Block(sum.streams[in],iBlk,uncompressed,mulfac);
+		Decode_Coefficients(uncompressed,in == 0 ? priv_work : priv_in,priv_compressed,blksize,nm,mulfac);
+		if (in == 0)
+		{
+			Scale_Block(priv_work,blksize,sum.weights[0]);
+		}
+		else
+		{
+			__m256 w = _mm256_set1_ps(sum.weights[in]);
+			for (int i = 0;  i < blksize;  i+=8)
+			{
+#ifdef __AVX2__
+				_mm256_storeu_ps(priv_work+i,_mm256_fmadd_ps(w,_mm256_loadu_ps(priv_in+i),_mm256_loadu_ps(priv_work+i)));
+#else
+				_mm256_storeu_ps(priv_work+i,_mm256_add_ps(_mm256_loadu_ps(priv_work+i),_mm256_mul_ps(w,_mm256_loadu_ps(priv_in+i))));
+#endif
+			}
+		}
+	}
+}
+
+/*
+ * Check that A and B have the same block grid and can be combined or compared block by block.
+ */
+static void Check_Compressed_Operands(
+	const char* caller,
+	const unsigned int* A,
+	const unsigned int* B,
+	bool allow_reversible
+	)
+{
+	int nt, bt, nc, nm;
+	Stream_Header_Words(A,nt,bt,nc,nm);
+	int ntB, btB, ncB, nmB;
+	Stream_Header_Words(B,ntB,btB,ncB,nmB);
+	bool same_shape = true;
+	for (int i = 0;  i < 6;  ++i) same_shape = same_shape && A[i] == B[i];
+	same_shape = same_shape && nt == ntB && bt == btB && nc == ncB && (A[7] & 112) == (B[7] & 112);
+	if (!same_shape)
+	{
+		printf("Error! %s: A and B must have the same shape, block size and layout!\n",caller);
+	}
+	assert(same_shape);
+	if ((A[7] & 1536) || (B[7] & 1536))
+	{
+		printf("Error! %s: adaptive streams and streams with excluded cells are not supported!\n",caller);
+	}
+	assert(!(A[7] & 1536) && !(B[7] & 1536));
+	// residuals of Compress_Delta only mean something together with the decoded reference they were predicted from.
+	if ((A[7] & 12) || (B[7] & 12))
+	{
+		printf("Error! %s: streams from Compress_Delta are not supported!\n",caller);
+	}
+	assert(!(A[7] & 12) && !(B[7] & 12));
+	if (!allow_reversible && ((A[7] & 2) || (B[7] & 2)))
+	{
+		printf("Error! %s: reversible streams are not supported!\n",caller);
+	}
+	assert(allow_reversible || (!(A[7] & 2) && !(B[7] & 2)));
+}
+
+/*
+ * Sum over the samples of one decoded block of products of a and b that fall inside the volume, b may be a.
+ * Blocks hold nc components of bx*by*bz*bt samples, the last block along every axis can stick out of the volume.
+ */
+static double Dot_Block_Samples(
+	const float* a,
+	const float* b,
+	int bx,
+	int by,
+	int bz,
+	int bt,
+	int nc,
+	int nx,
+	int ny,
+	int nz,
+	int nt
+	)
+{
+	__m256d acc = _mm256_setzero_pd();
+	double tail = 0.0;
+	for (int ic = 0;  ic < nc;  ++ic)
+	{
+		for (int it = 0;  it < bt && it < nt;  ++it)
+		{
+			for (int iz = 0;  iz < bz && iz < nz;  ++iz)
+			{
+				for (int iy = 0;  iy < by && iy < ny;  ++iy)
+				{
+					long off = (((long)(ic*bt+it)*bz+iz)*by+iy)*bx;
+					int ix = 0;
+					for (;  ix+4 <= bx && ix+4 <= nx;  ix+=4)
+					{
+#ifdef __AVX2__
+						acc = _mm256_fmadd_pd(Load4_As_Double(a+off+ix),Load4_As_Double(b+off+ix),acc);
+#else
+						acc = _mm256_add_pd(acc,_mm256_mul_pd(Load4_As_Double(a+off+ix),Load4_As_Double(b+off+ix)));
+#endif
+					}
+					for (;  ix < bx && ix < nx;  ++ix) tail += (double)a[off+ix] * (double)b[off+ix];
+				}
+			}
+		}
+	}
+	double v[4];
+	_mm256_storeu_pd(v,acc);
+	return (v[0] + v[1]) + (v[2] + v[3]) + tail;
+}
+
+/*
+ * Exact sum over all blocks of the products of the decoded samples of A and B, A and B may be the same stream.
+ * Every block is decoded and inverse transformed in the thread's private work area and reduced there,
+ * so nothing is written back to a volume. See Estimate_Dot_Blocks for the version that skips the inverse transform.
+ */
+static double Dot_Blocks(
+	CvxCompress& cvx,
+	unsigned int* A,
+	unsigned int* B,
+	int num_threads
+	)
+{
+	int nt, bt, nc, nm;
+	Stream_Header_Words(A,nt,bt,nc,nm);
+	int nx = A[0], ny = A[1], nz = A[2];
+	int bx = A[3], by = A[4], bz = A[5];
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	long nnn = Stream_Num_Blocks(A);
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,MAX(by,MAX(bz,bt)));
+#undef MAX
+	int blksize = bx*by*bz*bt*nc;
+	long work_size_one_thread = 2*(long)blksize + max_bs*8;
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+	double* partial = new double[num_threads];
+	for (int i = 0;  i < num_threads;  ++i) partial[i] = 0.0;
+	omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(dynamic)
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		long iit = iBlk / (nbx*nby*nbz);
+		long iiz = (iBlk - iit*nbx*nby*nbz) / (nbx*nby);
+		long iix = iBlk - (iit*nbz + iiz)*nbx*nby;
+		long iiy = iix / nbx;
+		iix = iix - iiy*nbx;
+
+		int thread_id = omp_get_thread_num();
+		float* priv_a = work + work_size_one_thread*thread_id;
+		float* priv_b = B == A ? priv_a : priv_a + blksize;
+		float* priv_tmp = priv_a + 2*blksize;
+		bool uncompressed;
+		const float* mulfac;
+		unsigned long* priv_compressed = Locate_Block(A,iBlk,uncompressed,mulfac);
+		Decode_Block(cvx,(A[7] & 2) != 0,uncompressed,priv_a,priv_tmp,priv_compressed,bx,by,bz,bt,nc,nm,mulfac);
+		if (B != A)
+		{
+			priv_compressed = Locate_Block(B,iBlk,uncompressed,mulfac);
+			Decode_Block(cvx,(B[7] & 2) != 0,uncompressed,priv_b,priv_tmp,priv_compressed,bx,by,bz,bt,nc,nm,mulfac);
+		}
+		partial[thread_id] += Dot_Block_Samples(priv_a,priv_b,bx,by,bz,bt,nc,nx-iix*bx,ny-iiy*by,nz-iiz*bz,nt-iit*bt);
+	}
+	double sum = 0.0;
+	for (int iThr = 0;  iThr < num_threads;  ++iThr) sum += partial[iThr];
+	delete [] partial;
+	free(work);
+	return sum;
+}
+
+/*
+ * Gram matrix of the 1D synthesis functions of a wavelet transform of length n along axis (0=x, 1=y, 2=z, 3=t),
+ * gram[i*n+j] is the inner product of the samples the inverse transform makes from unit coefficients i and j.
+ * The spatial transforms only come in 3D, so the functions are made in an 8x8xn (or similar) block and summed over the two 8 long axes,
+ * which scales every function by the same factor. That factor is measured with an impulse in an 8x8x8 block and divided out.
+ */
+static void Synthesis_Gram_Matrix(
+	int n,
+	int axis,
+	double* gram
+	)
+{
+	if (n == 1)
+	{
+		gram[0] = 1.0;
+		return;
+	}
+	int dim[3] = {8, 8, 8};
+	if (axis < 3) dim[axis] = n;
+	long blksize = axis < 3 ? (long)dim[0]*dim[1]*dim[2] : 8l*n;
+	long stride = axis == 0 ? 1 : axis == 1 ? dim[0] : axis == 2 ? dim[0]*dim[1] : 8;
+	float* blk;
+	posix_memalign((void**)&blk, 64, sizeof(float)*(blksize + 8*(n > 8 ? n : 8)));
+	float* tmp = blk + blksize;
+	double* f = new double[(long)n*n];
+	double norm = 1.0;
+	for (int i = -1;  i < n;  ++i)
+	{
+		// i == -1 is the impulse in the 8x8x8 block whose sum gives the scale factor.
+		for (long idx = 0;  idx < blksize;  ++idx) blk[idx] = 0.0f;
+		blk[i < 0 ? 0 : i*stride] = 1.0f;
+		if (axis == 3)
+			Wavelet_Transform_Fast_Inverse_T((__m256*)blk,(__m256*)tmp,8,n);
+		else
+			Wavelet_Transform_Fast_Inverse((__m256*)blk,(__m256*)tmp,i < 0 ? 8 : dim[0],i < 0 ? 8 : dim[1],i < 0 ? 8 : dim[2]);
+		if (i < 0)
+		{
+			if (axis < 3)
+			{
+				double sum = 0.0;
+				for (long idx = 0;  idx < 512;  ++idx) sum += blk[idx];
+				norm = cbrt(sum) * cbrt(sum);
+			}
+			continue;
+		}
+		for (int k = 0;  k < n;  ++k) f[(long)i*n+k] = 0.0;
+		for (long idx = 0;  idx < blksize;  ++idx) f[(long)i*n+(idx/stride)%n] += blk[idx];
+	}
+	for (int i = 0;  i < n;  ++i)
+		for (int j = 0;  j < n;  ++j)
+		{
+			double acc = 0.0;
+			for (int k = 0;  k < n;  ++k) acc += f[(long)i*n+k] * f[(long)j*n+k];
+			gram[(long)i*n+j] = acc / (norm * norm);
+		}
+	delete [] f;
+	free(blk);
+}
+
+/*
+ * The significant entries of the synthesis Gram matrices of the 4 axes of a bx*by*bz*bt block, stored by row.
+ * The 7-9 synthesis functions are nearly orthogonal except for the coarse scaling functions, which overlap heavily on a block,
+ * and neighbouring functions of the same band. Entries are kept if they couple two of the coarsest quarter of the functions,
+ * at least 4, or if they are more than 5% of the geometric mean of their diagonal entries, about 4 to 8 per row.
+ */
+struct Coefficient_Weights
+{
+	int n[4];
+	int* row[4];
+	int* col[4];
+	float* val[4];
+	float* xcol;  // kept entries of the x Gram matrix as dense columns, column j is non zero in rows 8*xlo[j] to 8*xhi[j]-1.
+	int* xlo;
+	int* xhi;
+};
+
+static void Init_Coefficient_Weights(Coefficient_Weights& w, int bx, int by, int bz, int bt)
+{
+	int n[4] = {bx, by, bz, bt};
+	for (int a = 0;  a < 4;  ++a)
+	{
+		w.n[a] = n[a];
+		int m = n[a] / 4 > 4 ? n[a] / 4 : (n[a] < 4 ? n[a] : 4);
+		double* gram = new double[(long)n[a]*n[a]];
+		Synthesis_Gram_Matrix(n[a],a,gram);
+		w.row[a] = new int[n[a]+1];
+		w.col[a] = new int[(long)n[a]*n[a]];
+		w.val[a] = new float[(long)n[a]*n[a]];
+		int nnz = 0;
+		for (int i = 0;  i < n[a];  ++i)
+		{
+			w.row[a][i] = nnz;
+			for (int j = 0;  j < n[a];  ++j)
+			{
+				double g = gram[(long)i*n[a]+j];
+				if ((i < m && j < m) || fabs(g) > 0.05 * sqrt(gram[(long)i*(n[a]+1)] * gram[(long)j*(n[a]+1)]))
+				{
+					w.col[a][nnz] = j;
+					w.val[a][nnz] = (float)g;
+					++nnz;
+				}
+			}
+		}
+		w.row[a][n[a]] = nnz;
+		delete [] gram;
+	}
+	int nx = w.n[0];
+	posix_memalign((void**)&w.xcol, 64, sizeof(float)*(long)nx*nx);
+	w.xlo = new int[nx];
+	w.xhi = new int[nx];
+	for (long i = 0;  i < (long)nx*nx;  ++i) w.xcol[i] = 0.0f;
+	for (int j = 0;  j < nx;  ++j)
+	{
+		w.xlo[j] = nx/8;
+		w.xhi[j] = 0;
+	}
+	for (int i = 0;  i < nx;  ++i)
+		for (int k = w.row[0][i];  k < w.row[0][i+1];  ++k)
+		{
+			int j = w.col[0][k];
+			w.xcol[(long)j*nx+i] = w.val[0][k];
+			w.xlo[j] = i/8 < w.xlo[j] ? i/8 : w.xlo[j];
+			w.xhi[j] = i/8+1 > w.xhi[j] ? i/8+1 : w.xhi[j];
+		}
+}
+
+static void Free_Coefficient_Weights(Coefficient_Weights& w)
+{
+	for (int a = 0;  a < 4;  ++a)
+	{
+		delete [] w.row[a];
+		delete [] w.col[a];
+		delete [] w.val[a];
+	}
+	free(w.xcol);
+	delete [] w.xlo;
+	delete [] w.xhi;
+}
+
+/*
+ * Multiply the coefficients in of a block by the kept Gram matrix entries of one axis. The matrices are symmetric,
+ * so row j also lists where coefficient j goes. Most quantized coefficients are zero, so the block is handled as
+ * x lines and in_ext / out_ext hold the number of leading 8 coefficient chunks of every line that may be non zero.
+ * Lines with extent 0 are zero and skipped, out is only written within out_ext.
+ */
+static void Apply_Axis_Gram(
+	const float* __restrict in,
+	const unsigned char* in_ext,
+	float* __restrict out,
+	unsigned char* out_ext,
+	const Coefficient_Weights& w,
+	int axis
+	)
+{
+	int bx = w.n[0];
+	long nline = (long)w.n[1]*w.n[2]*w.n[3];
+	for (long l = 0;  l < nline;  ++l) out_ext[l] = 0;
+	if (axis == 0)
+	{
+		// x, dense columns of the Gram matrix are added for the non zero coefficients of a line.
+		for (long l = 0;  l < nline;  ++l)
+		{
+			if (in_ext[l] == 0) continue;
+			const float* p = in + l*bx;
+			float* o = out + l*bx;
+			int ext = 0;
+			for (int j = 0;  j < 8*in_ext[l];  ++j)
+			{
+				if (p[j] == 0.0f) continue;
+				__m256 c = _mm256_set1_ps(p[j]);
+				const float* g = w.xcol + (long)j*bx;
+				for (int i = 8*ext;  i < 8*w.xhi[j];  i+=8) _mm256_storeu_ps(o+i,_mm256_setzero_ps());
+				ext = w.xhi[j] > ext ? w.xhi[j] : ext;
+				for (int i = 8*w.xlo[j];  i < 8*w.xhi[j];  i+=8)
+				{
+#ifdef __AVX2__
+					_mm256_storeu_ps(o+i,_mm256_fmadd_ps(c,_mm256_load_ps(g+i),_mm256_loadu_ps(o+i)));
+#else
+					_mm256_storeu_ps(o+i,_mm256_add_ps(_mm256_loadu_ps(o+i),_mm256_mul_ps(c,_mm256_load_ps(g+i))));
+#endif
+				}
+			}
+			out_ext[l] = ext;
+		}
+		return;
+	}
+	// y, z and t, x lines are scaled and added.
+	int n = w.n[axis];
+	long lstride = 1;
+	for (int a = 1;  a < axis;  ++a) lstride *= w.n[a];
+	long outer = nline / (lstride*n);
+	const int* row = w.row[axis];
+	const int* col = w.col[axis];
+	const float* val = w.val[axis];
+	for (long io = 0;  io < outer;  ++io)
+		for (int j = 0;  j < n;  ++j)
+			for (long il = 0;  il < lstride;  ++il)
+			{
+				long l = (io*n+j)*lstride+il;
+				int ext = in_ext[l];
+				if (ext == 0) continue;
+				const float* p = in + l*bx;
+				for (int k = row[j];  k < row[j+1];  ++k)
+				{
+					long lo = (io*n+col[k])*lstride+il;
+					float* o = out + lo*bx;
+					__m256 g = _mm256_set1_ps(val[k]);
+					for (int i = 8*out_ext[lo];  i < 8*ext;  i+=8) _mm256_storeu_ps(o+i,_mm256_setzero_ps());
+					out_ext[lo] = ext > out_ext[lo] ? ext : out_ext[lo];
+					for (int i = 0;  i < 8*ext;  i+=8)
+					{
+#ifdef __AVX2__
+						_mm256_storeu_ps(o+i,_mm256_fmadd_ps(g,_mm256_loadu_ps(p+i),_mm256_loadu_ps(o+i)));
+#else
+						_mm256_storeu_ps(o+i,_mm256_add_ps(_mm256_loadu_ps(o+i),_mm256_mul_ps(g,_mm256_loadu_ps(p+i))));
+#endif
+					}
+				}
+			}
+}
+
+/*
+ * Number of leading 8 coefficient chunks of every x line of a block that hold a non zero coefficient.
+ */
+static void Line_Extents(const float* c, long nline, int bx, unsigned char* ext)
+{
+	int nchunk = bx / 8;
+	for (long l = 0;  l < nline;  ++l)
+	{
+		int e = nchunk;
+		while (e > 0 && _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(c+l*bx+8*e-8),_mm256_setzero_ps(),_CMP_NEQ_UQ)) == 0) --e;
+		ext[l] = e;
+	}
+}
+
+/*
+ * Floats of scratch space Estimate_Block_Dot needs for a bx*by*bz*bt block.
+ */
+static long Estimate_Block_Dot_Scratch(const Coefficient_Weights& w)
+{
+	long blksize = (long)w.n[0]*w.n[1]*w.n[2]*w.n[3];
+	return 3*blksize + (4*(blksize/w.n[0])+3)/4;
+}
+
+/*
+ * Sum of the products of the samples of two bx*by*bz*bt blocks estimated from their wavelet coefficients a and b,
+ * without running the inverse transform. a and b may be the same, which gives the sample energy of the block.
+ * The products are weighted with the kept entries of the Gram matrices of the synthesis functions, see Coefficient_Weights,
+ * which keeps the estimate within a percent or so of the sample energy for smooth and for noisy blocks.
+ * The Gram matrix of the block is the Kronecker product of those of the axes, so x and y are applied to a and z and t to b,
+ * which keeps both sides about as sparse as the quantized coefficients.
+ * scratch must hold Estimate_Block_Dot_Scratch floats.
+ */
+static double Estimate_Block_Dot(
+	const float* a,
+	const float* b,
+	const Coefficient_Weights& w,
+	float* scratch
+	)
+{
+	int bx = w.n[0];
+	long blksize = (long)w.n[0]*w.n[1]*w.n[2]*w.n[3];
+	long nline = blksize / bx;
+	float* buf[3] = {scratch, scratch + blksize, scratch + 2*blksize};
+	unsigned char* ext[4];
+	for (int i = 0;  i < 4;  ++i) ext[i] = (unsigned char*)(scratch + 3*blksize) + i*nline;
+	// x and y on a, result in buf[1], extents in ext[1].
+	Line_Extents(a,nline,bx,ext[0]);
+	Apply_Axis_Gram(a,ext[0],buf[0],ext[1],w,0);
+	const float* ga = buf[0];
+	unsigned char* ga_ext = ext[1];
+	if (w.n[1] > 1)
+	{
+		Apply_Axis_Gram(buf[0],ext[1],buf[1],ext[0],w,1);
+		ga = buf[1];
+		ga_ext = ext[0];
+	}
+	// z and t on b, in buf[0] and buf[2].
+	unsigned char* gb_ext = ga_ext == ext[0] ? ext[1] : ext[0];
+	unsigned char* tmp_ext = ext[2];
+	Line_Extents(b,nline,bx,gb_ext);
+	const float* gb = b;
+	float* next = buf[0];
+	for (int axis = 2;  axis < 4;  ++axis)
+	{
+		if (w.n[axis] == 1) continue;
+		Apply_Axis_Gram(gb,gb_ext,next,tmp_ext,w,axis);
+		unsigned char* e = gb_ext;
+		gb_ext = tmp_ext;
+		tmp_ext = e == ga_ext ? ext[3] : e;
+		gb = next;
+		next = next == buf[0] ? buf[2] : buf[0];
+	}
+	double dot = 0.0;
+	for (long l = 0;  l < nline;  ++l)
+	{
+		int e = ga_ext[l] < gb_ext[l] ? ga_ext[l] : gb_ext[l];
+		if (e == 0) continue;
+		__m256 acc = _mm256_setzero_ps();
+		for (int i = 0;  i < 8*e;  i+=8) acc = _mm256_add_ps(acc,_mm256_mul_ps(_mm256_loadu_ps(ga+l*bx+i),_mm256_loadu_ps(gb+l*bx+i)));
+		float f[8];
+		_mm256_storeu_ps(f,acc);
+		dot += (double)f[0] + (double)f[1] + (double)f[2] + (double)f[3] + (double)f[4] + (double)f[5] + (double)f[6] + (double)f[7];
+	}
+	return dot;
+}
+
+/*
+ * Global RMS of every component of a linear combination of streams, estimated from the combined wavelet coefficients
+ * with Estimate_Block_Dot, so the blocks are only run length decoded. Blocks that stick out of the volume were zero padded
+ * by Copy_To_Block, so their energy is the energy of the samples inside the volume.
+ */
+static void Estimate_Sum_RMS(
+	const Compressed_Sum& sum,
+	int num_threads,
+	float* rms
+	)
+{
+	unsigned int* compressed = sum.streams[0];
+	int nt, bt, nc, nm;
+	Stream_Header_Words(compressed,nt,bt,nc,nm);
+	int nx = compressed[0], ny = compressed[1], nz = compressed[2];
+	Coefficient_Weights w;
+	Init_Coefficient_Weights(w,compressed[3],compressed[4],compressed[5],bt);
+	long nnn = Stream_Num_Blocks(compressed);
+	int cblksize = w.n[0]*w.n[1]*w.n[2]*w.n[3];
+	int blksize = cblksize*nc;
+	long work_size_one_thread = 2*(long)blksize + Estimate_Block_Dot_Scratch(w);
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+	double* partial = new double[(long)num_threads*nm];
+	for (long i = 0;  i < (long)num_threads*nm;  ++i) partial[i] = 0.0;
+	omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(dynamic)
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		int thread_id = omp_get_thread_num();
+		float* priv_work = work + work_size_one_thread*thread_id;
+		float* priv_scratch = priv_work + 2*blksize;
+		Sum_Block_Coefficients(sum,iBlk,priv_work,priv_work+blksize,blksize,nm);
+		for (int ic = 0;  ic < nc;  ++ic)
+		{
+			const float* c = priv_work+(long)ic*cblksize;
+			partial[(long)thread_id*nm+ic*nm/nc] += Estimate_Block_Dot(c,c,w,priv_scratch);
+		}
+	}
+	double nsamp = (double)nx * (double)ny * (double)nz * (double)nt * (double)(nc/nm);
+	for (int im = 0;  im < nm;  ++im)
+	{
+		double acc = 0.0;
+		for (int iThr = 0;  iThr < num_threads;  ++iThr) acc += partial[(long)iThr*nm+im];
+		rms[im] = (float)sqrt(acc/nsamp);
+	}
+	delete [] partial;
+	free(work);
+	Free_Coefficient_Weights(w);
+}
+
+/*
+ * Sum over all blocks of the products of the samples of A and B estimated from their wavelet coefficients with Estimate_Block_Dot,
+ * so the blocks are only run length decoded. A and B may be the same stream. If blkdot is not 0L, it receives the estimate of every block.
+ * Blocks that stick out of the volume were zero padded by Copy_To_Block, so their estimate covers the samples inside the volume.
+ */
+static double Estimate_Dot_Blocks(
+	unsigned int* A,
+	unsigned int* B,
+	int num_threads,
+	double* blkdot
+	)
+{
+	int nt, bt, nc, nm;
+	Stream_Header_Words(A,nt,bt,nc,nm);
+	Coefficient_Weights w;
+	Init_Coefficient_Weights(w,A[3],A[4],A[5],bt);
+	long nnn = Stream_Num_Blocks(A);
+	int cblksize = w.n[0]*w.n[1]*w.n[2]*w.n[3];
+	int blksize = cblksize*nc;
+	long work_size_one_thread = 2*(long)blksize + Estimate_Block_Dot_Scratch(w);
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+	double* partial = new double[num_threads];
+	for (int i = 0;  i < num_threads;  ++i) partial[i] = 0.0;
+	omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(dynamic)
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		int thread_id = omp_get_thread_num();
+		float* priv_a = work + work_size_one_thread*thread_id;
+		float* priv_b = B == A ? priv_a : priv_a + blksize;
+		float* priv_scratch = priv_a + 2*blksize;
+		bool uncompressed;
+		const float* mulfac;
+		unsigned long* priv_compressed = Locate_Block(A,iBlk,uncompressed,mulfac);
+		Decode_Coefficients(uncompressed,priv_a,priv_compressed,blksize,nm,mulfac);
+		if (B != A)
+		{
+			priv_compressed = Locate_Block(B,iBlk,uncompressed,mulfac);
+			Decode_Coefficients(uncompressed,priv_b,priv_compressed,blksize,nm,mulfac);
+		}
+		double blk_sum = 0.0;
+		for (int ic = 0;  ic < nc;  ++ic) blk_sum += Estimate_Block_Dot(priv_a+(long)ic*cblksize,priv_b+(long)ic*cblksize,w,priv_scratch);
+		if (blkdot != 0L) blkdot[iBlk] = blk_sum;
+		partial[thread_id] += blk_sum;
+	}
+	double sum = 0.0;
+	for (int iThr = 0;  iThr < num_threads;  ++iThr) sum += partial[iThr];
+	delete [] partial;
+	free(work);
+	Free_Coefficient_Weights(w);
+	return sum;
+}
+
+/*
+ * Cells to leave out of a stream, e.g. absorbing boundary layers or the water column.
+ * A cell is excluded if its byte in mask (packed nx*ny*nz with x fast, may be 0L) is non zero or it lies in one of the nbox boxes,
+ * box ibox covers boxes[6*ibox] <= x < boxes[6*ibox+3], boxes[6*ibox+1] <= y < boxes[6*ibox+4] and boxes[6*ibox+2] <= z < boxes[6*ibox+5].
+ * Compress_Volumes leaves out the blocks whose cells inside the volume are all excluded, they decode to fill.
+ */
+struct Cell_Exclusion
+{
+	const unsigned char* mask;
+	int nbox;
+	const int* boxes;
+	float fill;
+};
+
+/*
+ * True if all cells of the block at x0,y0,z0 that are inside the volume are excluded.
+ */
+static bool Block_Is_Excluded(
+	const Cell_Exclusion& exclude,
+	int x0,
+	int y0,
+	int z0,
+	int bx,
+	int by,
+	int bz,
+	int nx,
+	int ny,
+	int nz
+	)
+{
+	int x1 = x0+bx < nx ? x0+bx : nx;
+	int y1 = y0+by < ny ? y0+by : ny;
+	int z1 = z0+bz < nz ? z0+bz : nz;
+	// usually the block lies inside a single box.
+	for (int ibox = 0;  ibox < exclude.nbox;  ++ibox)
+	{
+		const int* box = exclude.boxes + 6*ibox;
+		if (box[0] <= x0 && box[1] <= y0 && box[2] <= z0 && x1 <= box[3] && y1 <= box[4] && z1 <= box[5]) return true;
+	}
+	for (long iz = z0;  iz < z1;  ++iz)
+	{
+		for (long iy = y0;  iy < y1;  ++iy)
+		{
+			for (int ix = x0;  ix < x1;  ++ix)
+			{
+				bool excluded = exclude.mask != 0L && exclude.mask[(iz*ny+iy)*nx+ix] != 0;
+				for (int ibox = 0;  ibox < exclude.nbox && !excluded;  ++ibox)
+				{
+					const int* box = exclude.boxes + 6*ibox;
+					excluded = box[0] <= ix && ix < box[3] && box[1] <= iy && iy < box[4] && box[2] <= iz && iz < box[5];
+				}
+				if (!excluded) return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*
+ * Shared implementation of Compress, Compress_Batch and Compress_Reversible.
+ * Compresses nvol volumes of the same shape, vols[i] goes to its own independent stream in compressed[i].
+ * The blocks of all volumes are scheduled over one thread team and share one workspace.
+ * reversible selects the integer 5/3 transform, in which case scale and use_local_RMS are ignored.
+ * T is the element type of the input volumes. Blocks are converted to float when they are copied in.
+ * Rows of each volume are ldx samples apart and slices ldy rows apart, ldx=nx and ldy=ny for packed volumes.
+ * z_fast means the volumes are packed with z as the fast axis instead, ldx and ldy are ignored.
+ * nt > 1 means every volume holds nt consecutive snapshots of nz slices each, compressed as 4D blocks bx*by*bz*bt.
+ * nc > 1 means every sample has nc interleaved components (packed volumes only), which share the block index.
+ * per_component_rms gives every component its own global or local RMS, otherwise all components share one.
+ * given_rms optionally holds the global RMS of every volume (nc values per volume with per_component_rms), it is computed from the volumes when it is 0L.
+ * For a single volume with one RMS, given_rms[0] == 0 is computed too and returned in given_rms[0].
+ * sum, if not 0L, replaces the single input volume with a linear combination of compressed streams, vols is not used then.
+ * exclude, if not 0L, leaves out blocks of excluded cells, only for packed 3D volumes with one component.
+ * scale holds ntier values. Every volume gets ntier streams, compressed[ivol*ntier+itier] is quantized with scale[itier].
+ * Blocks are copied in and transformed once no matter how many tiers there are.
+ * Returns overall compression ratio, the input counts once per tier.
+ */
+template<typename T>
+static float Compress_Volumes(
+	CvxCompress& cvx,
+	const float* scale,
+	int ntier,
+	bool reversible,
+	float quant_step,
+	T* const* vols,
+	int nvol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	int nc,
+	bool per_component_rms,
+	int ldx,
+	int ldy,
+	bool z_fast,
+	int bx,
+	int by,
+	int bz,
+	int bt,
+	bool use_local_RMS,
+	float* given_rms,
+	const Compressed_Sum* sum,
+	const Cell_Exclusion* exclude,
+	unsigned int* const* compressed,
+	int num_threads,
+	long* compressed_length 
+	)
+{
+	assert(cvx.Is_Valid_Block_Size(bx,by,bz));
+	assert(exclude == 0L || (nt == 1 && nc == 1 && sum == 0L && !z_fast));
+	assert(bt == 1 || (bt >= cvx.Min_BZ() && bt <= cvx.Max_BZ() && (bt % cvx.Block_Size_Step()) == 0 && !reversible));
+	assert(nc == 1 || (ldx == nx && ldy == ny && !z_fast && !reversible));
+	assert(ntier == 1 || !reversible);
+	use_local_RMS = use_local_RMS && !reversible;
+	int nm = per_component_rms ? nc : 1;
+	bool return_rms = given_rms != 0L && nvol == 1 && nm == 1 && sum == 0L && given_rms[0] <= 0.0f;
+	float* global_rms = new float[nvol*nm];
+	if (use_local_RMS || reversible)
+		for (int i = 0;  i < nvol*nm;  ++i) global_rms[i] = 1.0f;
+	else if (given_rms != 0L && !return_rms)
+		for (int i = 0;  i < nvol*nm;  ++i) global_rms[i] = given_rms[i];
+	else if (nm > 1)
+		for (int ivol = 0;  ivol < nvol;  ++ivol) Compute_Global_RMS_Components(vols[ivol],nc,nx,ny,nz*nt,global_rms+ivol*nm);
+	else if (nvol == 1)
+	{
+		global_rms[0] = Compute_Global_RMS(vols[0],nx*nc,ny,nz*nt,(z_fast?nx:ldx)*nc,z_fast?ny:ldy);
+		if (return_rms) given_rms[0] = global_rms[0];
+	}
+	else
+		Compute_Global_RMS_Batch(vols,nvol,nx*nc,ny,nz*nt,(z_fast?nx:ldx)*nc,z_fast?ny:ldy,global_rms);
+
+	omp_set_num_threads(num_threads);
+
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,MAX(by,MAX(bz,bt)));
+#undef MAX
+	int blksize = bx*by*bz*bt*nc;
+	int priv_blkoff_len = 262144 / blksize;
+	priv_blkoff_len = priv_blkoff_len > 1 ? priv_blkoff_len : 1;
+	int work_blkoff_buffer_size = priv_blkoff_len + 2;
+	int work_compress_buffer_size = priv_blkoff_len*blksize + (blksize>>2);
+	int work_wave_transform_buffer_size = blksize;
+	int work_wave_transform_tmp_buffer_size = max_bs*8;
+	int work_size_one_thread = 2*work_blkoff_buffer_size + work_compress_buffer_size + work_wave_transform_buffer_size + work_wave_transform_tmp_buffer_size;
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	// every thread has one private area per tier, the block is copied in and transformed in the area of tier 0.
+	int work_size = work_size_one_thread * num_threads * ntier;
+	if (work_size_one_thread != (work_size / (num_threads * ntier))) {printf("Error! work buffer too large!\n"); exit(-1);}
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size);
+	float* sum_work = 0L;
+	if (sum != 0L) posix_memalign((void**)&sum_work, 64, sizeof(float)*(long)blksize*num_threads);
+	// stream whose blocks are buffered in each private area.
+	int* priv_vol = new int[num_threads*ntier];
+#pragma omp parallel for schedule(static,1)
+	for (int iThread = 0;  iThread < num_threads;  ++iThread)
+	{
+		int thread_id = omp_get_thread_num();
+		for (int itier = 0;  itier < ntier;  ++itier)
+		{
+			int slot = thread_id*ntier + itier;
+			GET_PRIVATE_POINTERS(work,slot);
+			ASSERT_ALIGNMENT(priv_work);
+			ASSERT_ALIGNMENT(priv_tmp);
+			int* p = (int*)(work + slot * work_size_one_thread);
+			for (int i = 0;  i < work_size_one_thread;  ++i) p[i] = 0;
+			priv_vol[slot] = 0;
+		}
+	}
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	int nbt = (nt+bt-1)/bt;
+	int nnn = nbx*nby*nbz*nbt;
+	long snapshot_stride = (z_fast ? (long)nx*(long)ny*(long)nz : (long)ldx*(long)ldy*(long)nz) * nc;
+
+	// flags:
+	// 1 -> use local RMS (global RMS otherwise)
+	// 2 -> reversible integer 5/3 transform, word 6 holds quantization step (0 means lossless)
+	// 16 -> 4D blocks, words 8 and 9 hold nt and bt and the block offsets start after them
+	// 32 -> interleaved components, the next two words hold nc and 0
+	// 64 -> one RMS per component, the next nc words (rounded up to even) hold the global mulfac of each component,
+	//       and the local mulfacs are stored per block and component.
+	// 128 -> compact block index, see Write_Block_Index. Block offsets are kept outside the stream until all blocks are done.
+	// 256 -> fixed size blocks without an index, see Compress_Fixed_Volume.
+	// 512 -> octree blocks, words 8 and 9 hold the largest depth and 0, see Adaptive_Index.
+	// 1024 -> blocks of excluded cells are left out, the next two words hold the value they decode to and 0.
+	bool four_d = nt > 1 || bt > 1;
+	unsigned int flags = (use_local_RMS ? 1 : 0) | (reversible ? 2 : 0) | (four_d ? 16 : 0) | (nc > 1 ? 32 : 0) | (nm > 1 ? 64 : 0) | (exclude != 0L ? 1024 : 0);
+	int comp_word = 8 + (four_d ? 2 : 0);
+	int fill_word = comp_word + (nc > 1 ? 2 : 0);
+	int mulfac_word = fill_word + (exclude != 0L ? 2 : 0);
+	int hdr_words = mulfac_word + (nm > 1 ? (nm+1) & ~1 : 0);
+	// every volume gets one stream per tier, stream ivol*ntier+itier is compressed with scale[itier].
+	int nstream = nvol*ntier;
+	float* glob_mulfac = new float[nstream*nm];
+	float* priv_mulfac = new float[num_threads*ntier*nm];
+	long index_bytes = Reserved_Index_Bytes(nnn);
+	long** glob_blkoffs = new long*[nstream];
+	float** blkmulfac = new float*[nstream];
+	unsigned int** bytes = new unsigned int*[nstream];
+	long* byte_offset = new long[nstream];
+	for (int istream = 0;  istream < nstream;  ++istream)
+	{
+		int ivol = istream / ntier;
+		int itier = istream - ivol*ntier;
+		compressed[istream][0] = nx;
+		compressed[istream][1] = ny;
+		compressed[istream][2] = nz;
+		compressed[istream][3] = bx;
+		compressed[istream][4] = by;
+		compressed[istream][5] = bz;
+
+		for (int im = 0;  im < nm;  ++im)
+		{
+			float& mulfac = glob_mulfac[istream*nm+im];
+			mulfac = global_rms[ivol*nm+im] != 0.0f ? 1.0f / (global_rms[ivol*nm+im] * scale[itier]) : 1.0f;
+			// Some combinations of scale and global_rms lead to Inf when global_rms is very small
+			// breaking decompression.
+			mulfac = !isfinite(mulfac) ? 1.0f : mulfac;
+			// reversible streams store the quantization step instead.
+			if (reversible) mulfac = quant_step;
+		}
+		memcpy(compressed[istream]+6, &glob_mulfac[istream*nm], sizeof(float));
+		// printf("nx=%d, ny=%d, nz=%d, bx=%d, by=%d, bz=%d, mulfac=%e\n",nx,ny,nz,bx,by,bz,glob_mulfac[ivol]);
+		compressed[istream][7] = flags;
+		if (four_d)
+		{
+			compressed[istream][8] = nt;
+			compressed[istream][9] = bt;
+		}
+		if (nc > 1)
+		{
+			compressed[istream][comp_word] = nc;
+			compressed[istream][comp_word+1] = 0;
+		}
+		if (exclude != 0L)
+		{
+			memcpy(compressed[istream]+fill_word, &exclude->fill, sizeof(float));
+			compressed[istream][fill_word+1] = 0;
+		}
+		if (nm > 1)
+		{
+			compressed[istream][hdr_words-1] = 0;
+			memcpy(compressed[istream]+mulfac_word, &glob_mulfac[istream*nm], sizeof(float)*nm);
+		}
+
+		glob_blkoffs[istream] = new long[nnn];  // no need to initialize
+		char* after_index = (char*)(compressed[istream]+hdr_words) + index_bytes;
+		if (use_local_RMS)
+		{
+			blkmulfac[istream] = (float*)after_index;
+			bytes[istream] = (unsigned int*)(blkmulfac[istream]+nnn*nm);
+		}
+		else
+		{
+			blkmulfac[istream] = 0L;
+			bytes[istream] = (unsigned int*)after_index;
+		}
+		byte_offset[istream] = 0l;
+	}
+
+	// 2D blocks are small, so several are handed out per task to keep scheduling overhead down.
+	int blocks_per_task = bz == 1 ? 16384 / (bx*by) : 1;
+	blocks_per_task = blocks_per_task > 1 ? blocks_per_task : 1;
+#pragma omp parallel for schedule(dynamic,blocks_per_task)
+	for (long iGlobBlk = 0;  iGlobBlk < (long)nvol*nnn;  ++iGlobBlk)
+	{
+		int ivol = iGlobBlk / nnn;
+		long iBlk = iGlobBlk - (long)ivol*nnn;
+		long iit = iBlk / (nbx*nby*nbz);
+		long iiz = (iBlk - iit*nbx*nby*nbz) / (nbx*nby);
+		long iix = iBlk - (iit*nbz + iiz)*nbx*nby;
+		long iiy = iix / nbx;
+		iix = iix - iiy*nbx;
+
+		int x0 = iix*bx;
+		int y0 = iiy*by;
+		int z0 = iiz*bz;
+		int t0 = iit*bt;
+
+		//printf("iBlk=%d, x0=%d, y0=%d, z0=%d\n",iBlk,x0,y0,z0);
+
+		if (exclude != 0L && Block_Is_Excluded(*exclude,x0,y0,z0,bx,by,bz,nx,ny,nz))
+		{
+			for (int istream = ivol*ntier;  istream < (ivol+1)*ntier;  ++istream)
+			{
+				glob_blkoffs[istream][iBlk] = -1l;
+				if (use_local_RMS) blkmulfac[istream][iBlk] = 1.0f;
+			}
+			continue;
+		}
+
+		int thread_id = omp_get_thread_num();
+		float* blk_work = (float*)(work + thread_id * ntier * work_size_one_thread);
+		float* blk_tmp = blk_work + work_wave_transform_buffer_size;
+
+		for (int it = 0;  it < bt && sum == 0L;  ++it)
+		{
+			__m128* priv_snap = (__m128*)(blk_work + it*bx*by*bz);
+			if (t0+it >= nt)
+			{
+				// past the last snapshot, zero like the spatial edges.
+				for (int ic = 0;  ic < nc;  ++ic) memset(blk_work+(ic*bt+it)*bx*by*bz,0,sizeof(float)*bx*by*bz);
+				continue;
+			}
+			T* snap = vols[ivol] + (t0+it)*snapshot_stride;
+			if (nc > 1)
+				Copy_To_Block_Interleaved(snap,nc,x0,y0,z0,nx,ny,nz,priv_snap,(long)bt*bx*by*bz,bx,by,bz);
+			else if (z_fast)
+				Copy_To_Block_Z_Fast(snap,x0,y0,z0,nx,ny,nz,priv_snap,bx,by,bz);
+			else
+				Copy_To_Block(snap,x0,y0,z0,nx,ny,nz,ldx,ldy,priv_snap,bx,by,bz);
+		}
+		// the block is transformed once, tiers other than 0 quantize their own copy of the coefficients.
+		if (sum != 0L)
+			Sum_Block_Coefficients(*sum,iBlk,blk_work,sum_work+(long)blksize*thread_id,blksize,nm);
+		else if (!reversible)
+			Forward_Transform_Block(cvx,blk_work,blk_tmp,bx,by,bz,bt,nc);
+		for (int itier = ntier-1;  itier >= 0;  --itier)
+		{
+			int slot = thread_id*ntier + itier;
+			int istream = ivol*ntier + itier;
+			GET_PRIVATE_POINTERS(work,slot);
+			if (itier > 0) memcpy(priv_work,blk_work,sizeof(float)*blksize);
+
+			// private area only holds blocks from one stream at a time.
+			if (*priv_blkstore_idx >= 1 && priv_vol[slot] != istream)
+			{
+				int jstream = priv_vol[slot];
+				Flush_Private_Blocks(priv_blkstore_idx,priv_blkoff,priv_iBlk,priv_compress_buffer,bytes[jstream],glob_blkoffs[jstream],byte_offset[jstream]);
+			}
+			priv_vol[slot] = istream;
+
+			priv_iBlk[*priv_blkstore_idx] = iBlk;
+			int blkoff = priv_blkoff[*priv_blkstore_idx];
+			unsigned long* priv_compressed = (unsigned long*)(((char*)priv_compress_buffer) + blkoff);
+
+			float* mulfac = priv_mulfac + slot*nm;
+			for (int im = 0;  im < nm;  ++im) mulfac[im] = glob_mulfac[istream*nm+im];
+			bool uncompressed = false;
+			int bytepos;
+			if (reversible)
+				bytepos = Encode_Block(cvx,scale[itier],reversible,quant_step,use_local_RMS,priv_work,priv_tmp,priv_compressed,bx,by,bz,bt,nc,nm,mulfac,uncompressed);
+			else
+				bytepos = Encode_Coefficients(scale[itier],use_local_RMS,priv_work,priv_compressed,bx,by,blksize,nm,mulfac,uncompressed);
+			if (use_local_RMS)
+				for (int im = 0;  im < nm;  ++im) blkmulfac[istream][iBlk*nm+im] = mulfac[im];
+
+			++(*priv_blkstore_idx);
+			if (uncompressed) priv_blkoff[(*priv_blkstore_idx)-1] |= -2147483648;
+			priv_blkoff[*priv_blkstore_idx] = blkoff + bytepos;
+			if (*priv_blkstore_idx >= priv_blkoff_len)
+			{
+				// copy compressed blocks from private area to global area.
+				Flush_Private_Blocks(priv_blkstore_idx,priv_blkoff,priv_iBlk,priv_compress_buffer,bytes[istream],glob_blkoffs[istream],byte_offset[istream]);
+			}
+		}
+	}
+	for (int slot = 0;  slot < num_threads*ntier;  ++slot)
+	{
+		GET_PRIVATE_POINTERS(work,slot);
+		if (*priv_blkstore_idx >= 1)
+		{
+			// copy compressed blocks from private area to global area.
+			int jstream = priv_vol[slot];
+			Flush_Private_Blocks(priv_blkstore_idx,priv_blkoff,priv_iBlk,priv_compress_buffer,bytes[jstream],glob_blkoffs[jstream],byte_offset[jstream]);
+		}
+	}
+	long total_length = 0l;
+	for (int istream = 0;  istream < nstream;  ++istream)
+	{
+		compressed_length[istream] = 4*hdr_words + index_bytes + byte_offset[istream] + 7;
+		if (use_local_RMS) compressed_length[istream] += 4*nnn*nm;
+		Write_Block_Index(compressed[istream],glob_blkoffs[istream],compressed_length[istream]);
+		delete [] glob_blkoffs[istream];
+		total_length += compressed_length[istream];
+	}
+
+	free(work);
+	if (sum_work != 0L) free(sum_work);
+	delete [] priv_vol;
+	delete [] byte_offset;
+	delete [] bytes;
+	delete [] blkmulfac;
+	delete [] glob_blkoffs;
+	delete [] priv_mulfac;
+	delete [] glob_mulfac;
+	delete [] global_rms;
+	double ratio = ((double)nx * (double)ny * (double)nz * (double)nt * (double)nc * (double)nstream * (double)sizeof(T)) / (double)total_length;
+	return (float)ratio;
+}
+
+/*
+ * Compress a single volume, see Compress_Volumes.
+ */
+template<typename T>
+static float Compress_Volume(
+	CvxCompress& cvx,
+	float scale,
+	bool reversible,
+	float quant_step,
+	T* vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	bool z_fast,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float* given_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	return Compress_Volumes(cvx,&scale,1,reversible,quant_step,&vol,1,nx,ny,nz,1,1,false,ldx,ldy,z_fast,bx,by,bz,1,use_local_RMS,given_rms,0L,0L,&compressed,num_threads,&compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	bool use_local_RMS = false;
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	bool use_local_RMS = false;
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Volume(*this,scale,false,0.0f,vol,nx,ny,nz,nx,ny,false,bx,by,bz,use_local_RMS,&global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	double* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	double* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	double* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	double* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Volume(*this,scale,false,0.0f,vol,nx,ny,nz,nx,ny,false,bx,by,bz,use_local_RMS,&global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_float16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_float16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_float16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_float16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Volume(*this,scale,false,0.0f,vol,nx,ny,nz,nx,ny,false,bx,by,bz,use_local_RMS,&global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_bfloat16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_bfloat16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_bfloat16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	cvx_bfloat16* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Volume(*this,scale,false,0.0f,vol,nx,ny,nz,nx,ny,false,bx,by,bz,use_local_RMS,&global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	int ox,
+	int oy,
+	int oz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,ldx,ldy,ox,oy,oz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	int ox,
+	int oy,
+	int oz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress(scale,vol,nx,ny,nz,ldx,ldy,ox,oy,oz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	int ox,
+	int oy,
+	int oz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,ldx,ldy,ox,oy,oz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	int ox,
+	int oy,
+	int oz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	if (ox < 0 || oy < 0 || oz < 0 || ox+nx > ldx || oy+ny > ldy)
+	{
+		printf("Error! Compress: region nx=%d, ny=%d at ox=%d, oy=%d, oz=%d does not fit in ldx=%d, ldy=%d\n",nx,ny,ox,oy,oz,ldx,ldy);
+	}
+	assert(ox >= 0 && oy >= 0 && oz >= 0 && ox+nx <= ldx && oy+ny <= ldy);
+	float* origin = vol + ((long)oz * (long)ldy + (long)oy) * (long)ldx + ox;
+	return Compress_Volume(*this,scale,false,0.0f,origin,nx,ny,nz,ldx,ldy,false,bx,by,bz,use_local_RMS,&global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	std::complex<float>* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	std::complex<float>* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	std::complex<float>* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress(
+	float scale,
+	std::complex<float>* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	// std::complex<float> is laid out as two floats, real part first.
+	float* fvol = (float*)vol;
+	return Compress_Volumes(*this,&scale,1,false,0.0f,&fvol,1,nx,ny,nz,1,2,false,nx,ny,false,bx,by,bz,1,use_local_RMS,&global_rms,0L,0L,&compressed,num_threads,&compressed_length);
+}
+
+float CvxCompress::Compress_Components(
+	float scale,
+	float* vol,
+	int nc,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Components(scale,vol,nc,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Components(
+	float scale,
+	float* vol,
+	int nc,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	return Compress_Volumes(*this,&scale,1,false,0.0f,&vol,1,nx,ny,nz,1,nc,nc > 1,nx,ny,false,bx,by,bz,1,use_local_RMS,0L,0L,0L,&compressed,num_threads,&compressed_length);
+}
+
+float CvxCompress::Compress_Batch(
+	float scale,
+	const float* const* vols,
+	int nvol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* const* compressed,
+	long* compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Batch(scale,vols,nvol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Batch(
+	float scale,
+	const float* const* vols,
+	int nvol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* const* compressed,
+	int num_threads,
+	long* compressed_length 
+	)
+{
+	// volumes are only read, Copy_To_Block just isn't const correct.
+	return Compress_Volumes(*this,&scale,1,false,0.0f,(float* const*)vols,nvol,nx,ny,nz,1,1,false,nx,ny,false,bx,by,bz,1,use_local_RMS,0L,0L,0L,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Tiers(
+	const float* scale,
+	int ntier,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* const* compressed,
+	long* compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Tiers(scale,ntier,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Tiers(
+	const float* scale,
+	int ntier,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* const* compressed,
+	int num_threads,
+	long* compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_Tiers(scale,ntier,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Tiers(
+	const float* scale,
+	int ntier,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* const* compressed,
+	long* compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Tiers(scale,ntier,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Tiers(
+	const float* scale,
+	int ntier,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* const* compressed,
+	int num_threads,
+	long* compressed_length
+	)
+{
+	if (ntier < 1)
+	{
+		printf("Error! Compress_Tiers: ntier must be at least 1, got %d!\n",ntier);
+	}
+	assert(ntier >= 1);
+	return Compress_Volumes(*this,scale,ntier,false,0.0f,&vol,1,nx,ny,nz,1,1,false,nx,ny,false,bx,by,bz,1,use_local_RMS,&global_rms,0L,0L,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Z_Fast(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Z_Fast(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Z_Fast(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_Z_Fast(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Z_Fast(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Z_Fast(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Z_Fast(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Volume(*this,scale,false,0.0f,vol,nx,ny,nz,nx,ny,true,bx,by,bz,use_local_RMS,&global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_4D(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	int bx,
+	int by,
+	int bz,
+	int bt,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_4D(scale,vol,nx,ny,nz,nt,bx,by,bz,bt,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_4D(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	int bx,
+	int by,
+	int bz,
+	int bt,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_4D(scale,vol,nx,ny,nz,nt,bx,by,bz,bt,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_4D(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	int bx,
+	int by,
+	int bz,
+	int bt,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_4D(scale,vol,nx,ny,nz,nt,bx,by,bz,bt,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_4D(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	int bx,
+	int by,
+	int bz,
+	int bt,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Volumes(*this,&scale,1,false,0.0f,&vol,1,nx,ny,nz,nt,1,false,nx,ny,false,bx,by,bz,bt,use_local_RMS,&global_rms,0L,0L,&compressed,num_threads,&compressed_length);
+}
+
+float CvxCompress::Compress_Reversible(
+	float max_error,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	unsigned int* compressed,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Reversible(max_error,vol,nx,ny,nz,bx,by,bz,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Reversible(
+	float max_error,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	// Quantized values must fit comfortably in an int.
+	// Fall back on lossless mode if they don't, which also satisfies the error bound.
+	float quant_step = max_error > 0.0f ? 2.0f * max_error : 0.0f;
+	if (quant_step > 0.0f)
+	{
+		omp_set_num_threads(num_threads);
+		float max_abs = Compute_Max_Abs(vol,nx,ny,nz);
+		if (!(max_abs / quant_step < 1073741824.0f)) quant_step = 0.0f;
+	}
+	return Compress_Volume(*this,1.0f,true,quant_step,vol,nx,ny,nz,nx,ny,false,bx,by,bz,false,0L,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Masked(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	const unsigned char* mask,
+	int nbox,
+	const int* boxes,
+	float fill,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Masked(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,mask,nbox,boxes,fill,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Masked(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	const unsigned char* mask,
+	int nbox,
+	const int* boxes,
+	float fill,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_Masked(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,mask,nbox,boxes,fill,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Masked(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	const unsigned char* mask,
+	int nbox,
+	const int* boxes,
+	float fill,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Masked(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,mask,nbox,boxes,fill,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Masked(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	const unsigned char* mask,
+	int nbox,
+	const int* boxes,
+	float fill,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	Cell_Exclusion exclude = {mask, nbox, boxes, fill};
+	return Compress_Volumes(*this,&scale,1,false,0.0f,&vol,1,nx,ny,nz,1,1,false,nx,ny,false,bx,by,bz,1,use_local_RMS,&global_rms,0L,&exclude,&compressed,num_threads,&compressed_length);
+}
+
+/*
+ * Run length encode the coefficients of one block into at most budget bytes.
+ * Blocks that do not fit lose their smallest coefficients. Coefficients quantize to (int)(mulfac*coef), so a threshold of 1
+ * zeroes nothing that is not zero already and one above the largest quantized magnitude zeroes the whole block.
+ * The smallest threshold that fits is found by bisection, geometric while the bracket is wide.
+ * priv_pruned is aligned scratch space for blksize coefficients, budget must leave room for a block of zeros.
+ * Returns the number of bytes written to priv_compressed.
+ */
+static int Encode_Coefficients_Within(
+	float mulfac,
+	float* priv_work,
+	float* priv_pruned,
+	unsigned long* priv_compressed,
+	int blksize,
+	int budget
+	)
+{
+	int bytepos = 0;
+	Run_Length_Encode_Slow(mulfac,priv_work,blksize,priv_compressed,bytepos);
+	if (bytepos <= budget) return bytepos;
+	double max_abs = 0.0;
+	for (int i = 0;  i < blksize;  ++i)
+	{
+		double q = fabs((double)priv_work[i] * (double)mulfac);
+		max_abs = q > max_abs ? q : max_abs;
+	}
+	double lo = 1.0, hi = floor(max_abs) + 1.0;
+	while (hi - lo > 1.0)
+	{
+		double mid = hi > 4.0*lo ? floor(sqrt(lo*hi)) : floor(0.5*(lo+hi));
+		for (int i = 0;  i < blksize;  ++i) priv_pruned[i] = fabs((double)priv_work[i] * (double)mulfac) < mid ? 0.0f : priv_work[i];
+		bytepos = 0;
+		Run_Length_Encode_Slow(mulfac,priv_pruned,blksize,priv_compressed,bytepos);
+		if (bytepos <= budget) hi = mid; else lo = mid;
+	}
+	for (int i = 0;  i < blksize;  ++i) priv_pruned[i] = fabs((double)priv_work[i] * (double)mulfac) < hi ? 0.0f : priv_work[i];
+	bytepos = 0;
+	Run_Length_Encode_Slow(mulfac,priv_pruned,blksize,priv_compressed,bytepos);
+	assert(bytepos <= budget);
+	return bytepos;
+}
+
+/*
+ * Compress a volume into slots of block_bytes bytes, one per block, see Compress_Fixed_Size.
+ * The 8 bytes after the header hold block_bytes instead of a block index, block iBlk starts iBlk*block_bytes bytes after them.
+ * A slot starts with the multiplication factor of its block, which is the global one unless use_local_RMS is set,
+ * followed by the run length encoded coefficients and zeros up to the end of the slot.
+ */
+static float Compress_Fixed_Volume(
+	CvxCompress& cvx,
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& given_rms,
+	int block_bytes,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	assert(cvx.Is_Valid_Block_Size(bx,by,bz));
+	int blksize = bx*by*bz;
+	// a block of zeros is a single run length escape code of up to 4 bytes.
+	if (block_bytes < 8 || (block_bytes & 3) != 0)
+	{
+		printf("Error! Compress_Fixed_Size: block_bytes must be a multiple of 4 and at least 8, got %d!\n",block_bytes);
+	}
+	assert(block_bytes >= 8 && (block_bytes & 3) == 0);
+	omp_set_num_threads(num_threads);
+	float global_rms = 1.0f;
+	if (!use_local_RMS && given_rms > 0.0f)
+		global_rms = given_rms;
+	else if (!use_local_RMS)
+	{
+		global_rms = Compute_Global_RMS(vol,nx,ny,nz);
+		given_rms = global_rms;
+	}
+	float glob_mulfac = global_rms != 0.0f ? 1.0f / (global_rms * scale) : 1.0f;
+	glob_mulfac = !isfinite(glob_mulfac) ? 1.0f : glob_mulfac;
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	long nnn = (long)nbx*(long)nby*(long)nbz;
+
+	// flags:
+	// 256 -> fixed size blocks, the block index is replaced by the slot size.
+	compressed[0] = nx;
+	compressed[1] = ny;
+	compressed[2] = nz;
+	compressed[3] = bx;
+	compressed[4] = by;
+	compressed[5] = bz;
+	memcpy(compressed+6, &glob_mulfac, sizeof(float));
+	compressed[7] = 256;
+	*((long*)(compressed+8)) = (long)block_bytes;
+	char* slots = (char*)(compressed+10);
+
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,MAX(by,bz));
+#undef MAX
+	// work area, pruned coefficients, encoded block with room for 5/4 of the raw block plus the 8 byte stores of the encoder.
+	long work_size_one_thread = 2*(long)blksize + max_bs*8 + (5*(long)blksize)/4 + 8;
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+
+#pragma omp parallel for schedule(dynamic)
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		long iiz = iBlk / (nbx*nby);
+		long iix = iBlk - iiz*nbx*nby;
+		long iiy = iix / nbx;
+		iix = iix - iiy*nbx;
+
+		int thread_id = omp_get_thread_num();
+		float* priv_work = work + work_size_one_thread*thread_id;
+		float* priv_pruned = priv_work + blksize;
+		float* priv_tmp = priv_pruned + blksize;
+		unsigned long* priv_compressed = (unsigned long*)(priv_tmp + max_bs*8);
+		ASSERT_ALIGNMENT(priv_work);
+		ASSERT_ALIGNMENT(priv_pruned);
+
+		Copy_To_Block(vol,iix*bx,iiy*by,iiz*bz,nx,ny,nz,nx,ny,(__m128*)priv_work,bx,by,bz);
+		Forward_Transform_Block(cvx,priv_work,priv_tmp,bx,by,bz,1,1);
+		float mulfac = glob_mulfac;
+		if (use_local_RMS)
+		{
+			float local_RMS = Compute_Local_RMS((__m256*)priv_work,bx,by,bz);
+			mulfac = local_RMS != 0.0f ? 1.0f / (local_RMS * scale) : 1.0f;
+		}
+		int bytepos = Encode_Coefficients_Within(mulfac,priv_work,priv_pruned,priv_compressed,blksize,block_bytes-4);
+		char* slot = slots + iBlk*block_bytes;
+		memcpy(slot,&mulfac,sizeof(float));
+		memcpy(slot+4,priv_compressed,bytepos);
+		memset(slot+4+bytepos,0,block_bytes-4-bytepos);
+	}
+	free(work);
+
+	compressed_length = 40 + nnn*block_bytes + 7;
+	double ratio = ((double)nx * (double)ny * (double)nz * (double)sizeof(float)) / (double)compressed_length;
+	return (float)ratio;
+}
+
+float CvxCompress::Compress_Fixed_Size(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	int block_bytes,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Fixed_Size(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,block_bytes,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Fixed_Size(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	int block_bytes,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_Fixed_Size(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,block_bytes,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Fixed_Size(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	int block_bytes,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Fixed_Size(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,block_bytes,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Fixed_Size(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	int block_bytes,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Fixed_Volume(*this,scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,block_bytes,compressed,num_threads,compressed_length);
+}
+
+/*
+ * Adaptive streams (flag 512) split the volume into bx*by*bz blocks like other streams, but every block is an octree
+ * whose leaves are encoded as blocks of their own. A leaf at depth d is (bx>>d)*(by>>d)*(bz>>d) samples, children
+ * that start outside the volume are left out. Word 8 holds the largest depth and word 9 is 0.
+ * The leaves of a block are encoded one after the other, so the block index is replaced by a two level index
+ *   long block_offset[nnn]                offset of every block into the encoded bytes
+ *   unsigned int first_leaf[nnn+1]        rounded up to an even count, the leaves of block iBlk are first_leaf[iBlk] to first_leaf[iBlk+1]-1
+ *   unsigned int leaf_offset[nleaf]       rounded up to an even count, offset of every leaf from its block, the top bit flags an uncompressed leaf
+ *   unsigned char leaf_depth[nleaf]       rounded up to a multiple of 8, the leaves of a block are in depth first order
+ *   float leaf_mulfac[nleaf]              rounded up to an even count, only for local RMS streams
+ */
+static void Adaptive_Index(
+	unsigned int* compressed,
+	long*& block_offset,
+	unsigned int*& first_leaf,
+	unsigned int*& leaf_offset,
+	unsigned char*& leaf_depth,
+	float*& leaf_mulfac,
+	char*& bytes
+	)
+{
+	int nt, bt, nc, nm;
+	long nnn = Stream_Num_Blocks(compressed);
+	block_offset = (long*)(compressed + Stream_Header_Words(compressed,nt,bt,nc,nm));
+	first_leaf = (unsigned int*)(block_offset + nnn);
+	long nleaf = first_leaf[nnn];
+	leaf_offset = first_leaf + ((nnn+2) & ~1l);
+	leaf_depth = (unsigned char*)(leaf_offset + ((nleaf+1) & ~1l));
+	leaf_mulfac = (float*)(leaf_depth + ((nleaf+7) & ~7l));
+	bytes = (compressed[7] & 1) ? (char*)(leaf_mulfac + ((nleaf+1) & ~1l)) : (char*)leaf_mulfac;
+}
+
+/*
+ * Mean square of the samples of a region of a packed volume, the part of the region outside the volume is ignored.
+ */
+static double Region_Mean_Square(const float* vol, int nx, int ny, int nz, int x0, int y0, int z0, int sx, int sy, int sz)
+{
+	int x1 = x0+sx < nx ? x0+sx : nx;
+	int y1 = y0+sy < ny ? y0+sy : ny;
+	int z1 = z0+sz < nz ? z0+sz : nz;
+	double acc = 0.0;
+	for (long iz = z0;  iz < z1;  ++iz)
+	{
+		for (long iy = y0;  iy < y1;  ++iy)
+		{
+			const float* row = vol + (iz*ny+iy)*nx;
+			for (int ix = x0;  ix < x1;  ++ix) acc += (double)row[ix] * (double)row[ix];
+		}
+	}
+	long n = (long)(x1-x0) * (long)(y1-y0) * (long)(z1-z0);
+	return n > 0 ? acc / (double)n : 0.0;
+}
+
+/*
+ * Build the octree of a region, regions with a mean square above split_ms are halved along every axis until max_depth.
+ * Appends the depths of the leaves to leaf_depth in depth first order.
+ */
+static void Split_Adaptive_Block(
+	const float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int x0,
+	int y0,
+	int z0,
+	int sx,
+	int sy,
+	int sz,
+	int depth,
+	int max_depth,
+	double split_ms,
+	unsigned char* leaf_depth,
+	int& nleaf
+	)
+{
+	if (depth < max_depth && Region_Mean_Square(vol,nx,ny,nz,x0,y0,z0,sx,sy,sz) > split_ms)
+	{
+		int hx = sx/2, hy = sy/2, hz = sz/2;
+		for (int iz = 0;  iz < 2;  ++iz)
+			for (int iy = 0;  iy < 2;  ++iy)
+				for (int ix = 0;  ix < 2;  ++ix)
+					if (x0+ix*hx < nx && y0+iy*hy < ny && z0+iz*hz < nz)
+						Split_Adaptive_Block(vol,nx,ny,nz,x0+ix*hx,y0+iy*hy,z0+iz*hz,hx,hy,hz,depth+1,max_depth,split_ms,leaf_depth,nleaf);
+	}
+	else
+	{
+		leaf_depth[nleaf++] = (unsigned char)depth;
+	}
+}
+
+/*
+ * Inverse of Split_Adaptive_Block. Walks the octree given by the leaf depths and stores the origin of every leaf in leaf_origin.
+ */
+static void Walk_Adaptive_Block(
+	const unsigned char* leaf_depth,
+	int& ileaf,
+	int depth,
+	int x0,
+	int y0,
+	int z0,
+	int sx,
+	int sy,
+	int sz,
+	int nx,
+	int ny,
+	int nz,
+	int* leaf_origin
+	)
+{
+	if (leaf_depth[ileaf] == depth)
+	{
+		leaf_origin[3*ileaf] = x0;
+		leaf_origin[3*ileaf+1] = y0;
+		leaf_origin[3*ileaf+2] = z0;
+		++ileaf;
+		return;
+	}
+	int hx = sx/2, hy = sy/2, hz = sz/2;
+	for (int iz = 0;  iz < 2;  ++iz)
+		for (int iy = 0;  iy < 2;  ++iy)
+			for (int ix = 0;  ix < 2;  ++ix)
+				if (x0+ix*hx < nx && y0+iy*hy < ny && z0+iz*hz < nz)
+					Walk_Adaptive_Block(leaf_depth,ileaf,depth+1,x0+ix*hx,y0+iy*hy,z0+iz*hz,hx,hy,hz,nx,ny,nz,leaf_origin);
+}
+
+/*
+ * Compress a volume with octree blocks, see Compress_Adaptive and Adaptive_Index for the layout.
+ * The octrees are built first, so the size of the index is known before the leaves are encoded.
+ * Each thread encodes all leaves of one block into its private buffer and then appends them to the stream in one piece.
+ */
+static float Compress_Adaptive_Volume(
+	CvxCompress& cvx,
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	int max_depth,
+	float split_rms,
+	bool use_local_RMS,
+	float& given_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	bool valid = max_depth >= 0 && max_depth <= 5 && bz > 1 && cvx.Is_Valid_Block_Size(bx,by,bz) &&
+		((bx >> max_depth) << max_depth) == bx && ((by >> max_depth) << max_depth) == by && ((bz >> max_depth) << max_depth) == bz &&
+		cvx.Is_Valid_Block_Size(bx >> max_depth,by >> max_depth,bz >> max_depth);
+	if (!valid)
+	{
+		printf("Error! Compress_Adaptive: %d x %d x %d blocks cannot be halved %d times into valid block sizes!\n",bx,by,bz,max_depth);
+	}
+	assert(valid);
+	omp_set_num_threads(num_threads);
+	// the global RMS decides where blocks are split, even when the blocks are quantized with their local RMS.
+	float global_rms;
+	if (given_rms > 0.0f)
+		global_rms = given_rms;
+	else
+	{
+		global_rms = Compute_Global_RMS(vol,nx,ny,nz);
+		given_rms = global_rms;
+	}
+	float quant_rms = use_local_RMS ? 1.0f : global_rms;
+	float glob_mulfac = quant_rms != 0.0f ? 1.0f / (quant_rms * scale) : 1.0f;
+	glob_mulfac = !isfinite(glob_mulfac) ? 1.0f : glob_mulfac;
+	double split_ms = (double)split_rms * (double)global_rms;
+	split_ms = split_ms * split_ms;
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	long nnn = (long)nbx*(long)nby*(long)nbz;
+	int max_leaves = 1 << (3*max_depth);
+	unsigned char* tree = new unsigned char[nnn*max_leaves];
+	int* nleaf_blk = new int[nnn];
+#pragma omp parallel for schedule(dynamic)
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		long iiz = iBlk / (nbx*nby);
+		long iix = iBlk - iiz*nbx*nby;
+		long iiy = iix / nbx;
+		iix = iix - iiy*nbx;
+		nleaf_blk[iBlk] = 0;
+		Split_Adaptive_Block(vol,nx,ny,nz,iix*bx,iiy*by,iiz*bz,bx,by,bz,0,max_depth,split_ms,tree+iBlk*max_leaves,nleaf_blk[iBlk]);
+	}
+
+	compressed[0] = nx;
+	compressed[1] = ny;
+	compressed[2] = nz;
+	compressed[3] = bx;
+	compressed[4] = by;
+	compressed[5] = bz;
+	memcpy(compressed+6, &glob_mulfac, sizeof(float));
+	compressed[7] = 512 | (use_local_RMS ? 1 : 0);
+	compressed[8] = max_depth;
+	compressed[9] = 0;
+	long* block_offset = (long*)(compressed+10);
+	unsigned int* first_leaf = (unsigned int*)(block_offset+nnn);  // where Adaptive_Index finds it
+	long nleaf = 0;
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		first_leaf[iBlk] = nleaf;
+		nleaf += nleaf_blk[iBlk];
+	}
+	first_leaf[nnn] = nleaf;
+	if (!(nnn & 1)) first_leaf[nnn+1] = 0;
+	unsigned int* leaf_offset;
+	unsigned char* leaf_depth;
+	float* leaf_mulfac;
+	char* bytes;
+	Adaptive_Index(compressed,block_offset,first_leaf,leaf_offset,leaf_depth,leaf_mulfac,bytes);
+	if (nleaf & 1) leaf_offset[nleaf] = 0;
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk) memcpy(leaf_depth+first_leaf[iBlk],tree+iBlk*max_leaves,nleaf_blk[iBlk]);
+	memset(leaf_depth+nleaf,0,((nleaf+7) & ~7l)-nleaf);
+	if (use_local_RMS && (nleaf & 1)) leaf_mulfac[nleaf] = 0.0f;
+
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,MAX(by,bz));
+#undef MAX
+	int blksize = bx*by*bz;
+	// the leaves of a block are at most as large as the raw block, plus 1/4 of a leaf while the last one is encoded.
+	long work_size_one_thread = (long)blksize + max_bs*8 + (long)blksize + (blksize>>2) + 16;
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+	int* origin = new int[(long)3*max_leaves*num_threads];
+	long byte_offset = 0l;
+#pragma omp parallel for schedule(dynamic)
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		long iiz = iBlk / (nbx*nby);
+		long iix = iBlk - iiz*nbx*nby;
+		long iiy = iix / nbx;
+		iix = iix - iiy*nbx;
+
+		int thread_id = omp_get_thread_num();
+		float* priv_work = work + work_size_one_thread*thread_id;
+		float* priv_tmp = priv_work + blksize;
+		char* priv_compress_buffer = (char*)(priv_tmp + max_bs*8);
+		int* leaf_origin = origin + (long)3*max_leaves*thread_id;
+		const unsigned char* blk_depth = leaf_depth + first_leaf[iBlk];
+		int nblk_leaf = 0;
+		Walk_Adaptive_Block(blk_depth,nblk_leaf,0,iix*bx,iiy*by,iiz*bz,bx,by,bz,nx,ny,nz,leaf_origin);
+		assert(nblk_leaf == nleaf_blk[iBlk]);
+
+		int bytepos = 0;
+		for (int ileaf = 0;  ileaf < nblk_leaf;  ++ileaf)
+		{
+			int lx = bx >> blk_depth[ileaf], ly = by >> blk_depth[ileaf], lz = bz >> blk_depth[ileaf];
+			Copy_To_Block(vol,leaf_origin[3*ileaf],leaf_origin[3*ileaf+1],leaf_origin[3*ileaf+2],nx,ny,nz,nx,ny,(__m128*)priv_work,lx,ly,lz);
+			float mulfac = glob_mulfac;
+			bool uncompressed = false;
+			int nbytes = Encode_Block(cvx,scale,false,0.0f,use_local_RMS,priv_work,priv_tmp,(unsigned long*)(priv_compress_buffer+bytepos),lx,ly,lz,1,1,1,&mulfac,uncompressed);
+			if (use_local_RMS) leaf_mulfac[first_leaf[iBlk]+ileaf] = mulfac;
+			leaf_offset[first_leaf[iBlk]+ileaf] = uncompressed ? ((unsigned int)bytepos | 0x80000000) : (unsigned int)bytepos;
+			bytepos += nbytes;
+		}
+		char* glob_dst = 0L;
+#pragma omp critical
+		{
+			glob_dst = bytes + byte_offset;
+			byte_offset += (long)bytepos;
+		}
+		memcpy(glob_dst,priv_compress_buffer,bytepos);
+		block_offset[iBlk] = glob_dst - bytes;
+	}
+	free(work);
+	delete [] origin;
+	delete [] nleaf_blk;
+	delete [] tree;
+
+	compressed_length = (bytes - (char*)compressed) + byte_offset + 7;
+	double ratio = ((double)nx * (double)ny * (double)nz * (double)sizeof(float)) / (double)compressed_length;
+	return (float)ratio;
+}
+
+float CvxCompress::Compress_Adaptive(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	int max_depth,
+	float split_rms,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Adaptive(scale,vol,nx,ny,nz,bx,by,bz,max_depth,split_rms,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Adaptive(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	int max_depth,
+	float split_rms,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_Adaptive(scale,vol,nx,ny,nz,bx,by,bz,max_depth,split_rms,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Adaptive(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	int max_depth,
+	float split_rms,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Adaptive(scale,vol,nx,ny,nz,bx,by,bz,max_depth,split_rms,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Adaptive(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	int max_depth,
+	float split_rms,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* compressed,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	return Compress_Adaptive_Volume(*this,scale,vol,nx,ny,nz,bx,by,bz,max_depth,split_rms,use_local_RMS,global_rms,compressed,num_threads,compressed_length);
+}
+
+/*
+ * Makes Decompress_Volumes add the decoded samples to the output volume instead of overwriting it.
+ * Adds alpha times the decoded samples, or src times the decoded samples if src is not NULL.
+ * src has the same dimensions and strides as the output volume. Only float volumes can be accumulated into.
+ */
+struct Decoded_Accumulation
+{
+	float alpha;
+	const float* src;
+};
+
+/*
+ * Type of the acc argument of the decompress drivers for volumes of type T. Other volume types get a pointer to
+ * an incomplete type, so the only accumulation they can be handed is NULL and accumulating into them does not compile.
+ */
+struct No_Accumulation;
+template<typename T> struct Accumulation_Of {typedef No_Accumulation type;};
+template<> struct Accumulation_Of<float> {typedef Decoded_Accumulation type;};
+
+template<typename T>
+static void Accumulate_From_Block(const No_Accumulation* acc, __m128* work, int bx, int by, int bz, T* data, long src_offset, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	// never called, acc can only be NULL.
+}
+
+static void Accumulate_From_Block(const Decoded_Accumulation* acc, __m128* work, int bx, int by, int bz, float* data, long src_offset, int x0, int y0, int z0, int nx, int ny, int nz, int ldx, int ldy)
+{
+	if (acc->src != 0L)
+		Copy_From_Block_Multiply_Accumulate(work,bx,by,bz,acc->src+src_offset,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+	else
+		Copy_From_Block_Accumulate(work,bx,by,bz,acc->alpha,data,x0,y0,z0,nx,ny,nz,ldx,ldy);
+}
+
+/*
+ * Decompress an adaptive stream made by Compress_Adaptive_Volume, the arguments are those of Decompress_Volumes for one volume.
+ */
+template<typename T>
+static void Decompress_Adaptive_Volume(
+	CvxCompress& cvx,
+	T* vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	bool z_fast,
+	const typename Accumulation_Of<T>::type* acc,
+	unsigned int* compressed,
+	int num_threads
+	)
+{
+	int bx = compressed[3], by = compressed[4], bz = compressed[5];
+	int max_depth = compressed[8];
+	bool use_local_RMS = (compressed[7] & 1) ? true : false;
+	float glob_mulfac;
+	memcpy(&glob_mulfac, compressed+6, sizeof(float));
+	long* block_offset;
+	unsigned int* first_leaf;
+	unsigned int* leaf_offset;
+	unsigned char* leaf_depth;
+	float* leaf_mulfac;
+	char* bytes;
+	Adaptive_Index(compressed,block_offset,first_leaf,leaf_offset,leaf_depth,leaf_mulfac,bytes);
+
+	omp_set_num_threads(num_threads);
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	long nnn = (long)nbx*(long)nby*(long)nbz;
+	int max_leaves = 1 << (3*max_depth);
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,MAX(by,bz));
+#undef MAX
+	int blksize = bx*by*bz;
+	int work_size_one_thread = (blksize + max_bs*8);
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+	int* origin = new int[(long)3*max_leaves*num_threads];
+
+#pragma omp parallel for schedule(dynamic)
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		long iiz = iBlk / (nbx*nby);
+		long iix = iBlk - iiz*nbx*nby;
+		long iiy = iix / nbx;
+		iix = iix - iiy*nbx;
+
+		int thread_id = omp_get_thread_num();
+		float* priv_work = work + work_size_one_thread * thread_id;
+		float* priv_tmp = priv_work + blksize;
+		int* leaf_origin = origin + (long)3*max_leaves*thread_id;
+		long ileaf0 = first_leaf[iBlk];
+		int nblk_leaf = 0;
+		Walk_Adaptive_Block(leaf_depth+ileaf0,nblk_leaf,0,iix*bx,iiy*by,iiz*bz,bx,by,bz,nx,ny,nz,leaf_origin);
+		for (int ileaf = 0;  ileaf < nblk_leaf;  ++ileaf)
+		{
+			int depth = leaf_depth[ileaf0+ileaf];
+			int lx = bx >> depth, ly = by >> depth, lz = bz >> depth;
+			int x0 = leaf_origin[3*ileaf], y0 = leaf_origin[3*ileaf+1], z0 = leaf_origin[3*ileaf+2];
+			unsigned int rel = leaf_offset[ileaf0+ileaf];
+			bool uncompressed = (rel & 0x80000000) ? true : false;
+			char* leaf_bytes = bytes + block_offset[iBlk] + (rel & 0x7FFFFFFF);
+			const float* mulfac = use_local_RMS ? leaf_mulfac + ileaf0 + ileaf : &glob_mulfac;
+			Decode_Block(cvx,false,uncompressed,priv_work,priv_tmp,(unsigned long*)leaf_bytes,lx,ly,lz,1,1,1,mulfac);
+			if (acc != 0L)
+				Accumulate_From_Block(acc,(__m128*)priv_work,lx,ly,lz,vol,0l,x0,y0,z0,nx,ny,nz,ldx,ldy);
+			else if (z_fast)
+				Copy_From_Block_Z_Fast((__m128*)priv_work,lx,ly,lz,vol,x0,y0,z0,nx,ny,nz);
+			else
+				Copy_From_Block((__m128*)priv_work,lx,ly,lz,vol,x0,y0,z0,nx,ny,nz,ldx,ldy);
+		}
+	}
+
+	free(work);
+	delete [] origin;
+}
+
+/*
+ * Shared implementation of Decompress and Decompress_Batch.
+ * Decompresses nvol streams of the same shape and block size, stream compressed[i] goes to vols[i].
+ * The blocks of all streams are scheduled over one thread team and share one workspace.
+ * T is the element type of the output volumes.
+ * Rows of each volume are ldx samples apart and slices ldy rows apart, ldx=nx and ldy=ny for packed volumes.
+ * z_fast means the volumes are packed with z as the fast axis instead, ldx and ldy are ignored.
+ * nt is the number of snapshots in each volume, streams with 4D blocks must be decoded with the nt they were made with.
+ * nc is the number of interleaved components per sample, it must match the stream as well.
+ * acc is NULL to overwrite the output volume, otherwise the decoded samples are accumulated into it, see Decoded_Accumulation.
+ * Accumulation requires a single volume with one component and x as the fast axis.
+ * residual must be true to decode streams from Compress_Delta, which only Decompress_Delta does since they decode to the residual.
+ */
+template<typename T>
+static void Decompress_Volumes(
+	CvxCompress& cvx,
+	T* const* vols,
+	int nvol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	int nc,
+	int ldx,
+	int ldy,
+	bool z_fast,
+	const typename Accumulation_Of<T>::type* acc,
+	bool residual,
+	unsigned int* const* compressed,
+	int num_threads,
+	const long* compressed_length 
+	)
+{
+	if (acc != 0L && (nvol != 1 || nc != 1 || z_fast))
+	{
+		printf("Error! Decompress_Accumulate: accumulation needs a single volume with one component and x as the fast axis!\n");
+	}
+	assert(acc == 0L || (nvol == 1 && nc == 1 && !z_fast));
+	for (int ivol = 0;  ivol < nvol;  ++ivol)
+	{
+		if (!residual && (compressed[ivol][7] & 12))
+		{
+			printf("Error! Decompress: stream %d holds a residual from Compress_Delta, decompress it with Decompress_Delta!\n",ivol);
+		}
+		assert(residual || !(compressed[ivol][7] & 12));
+	}
+	if (((int*)compressed[0])[7] & 512)
+	{
+		// adaptive streams have their own block layout.
+		for (int ivol = 0;  ivol < nvol;  ++ivol)
+		{
+			unsigned int* A = compressed[ivol];
+			bool same = (A[7] & 512) && (int)A[0] == nx && (int)A[1] == ny && (int)A[2] == nz && nt == 1 && nc == 1;
+			if (!same)
+			{
+				printf("Error! Decompress: adaptive stream holds a %d x %d x %d volume, expected %d x %d x %d with %d snapshots and %d components!\n",A[0],A[1],A[2],nx,ny,nz,nt,nc);
+			}
+			assert(same);
+			Decompress_Adaptive_Volume(cvx,vols[ivol],nx,ny,nz,ldx,ldy,z_fast,acc,A,num_threads);
+		}
+		return;
+	}
+	int bx = ((int*)compressed[0])[3];
+	int by = ((int*)compressed[0])[4];
+	int bz = ((int*)compressed[0])[5];
+	bool four_d = (((int*)compressed[0])[7] & 16) ? true : false;
+	int bt = four_d ? ((int*)compressed[0])[9] : 1;
+	bool interleaved = (((int*)compressed[0])[7] & 32) ? true : false;
+	bool masked = (((int*)compressed[0])[7] & 1024) ? true : false;
+	int comp_word = 8 + (four_d ? 2 : 0);
+	int mulfac_word = comp_word + (interleaved ? 2 : 0) + (masked ? 2 : 0);
+	int nm = (((int*)compressed[0])[7] & 64) ? nc : 1;
+	int hdr_words = mulfac_word + (nm > 1 ? (nm+1) & ~1 : 0);
+	for (int ivol = 0;  ivol < nvol;  ++ivol)
+	{
+		int nx_check = ((int*)compressed[ivol])[0];
+		int ny_check = ((int*)compressed[ivol])[1];
+		int nz_check = ((int*)compressed[ivol])[2];
+		// Check sizes and print error message if they don't match.
+		// for nx ny and nz
+		if (nx != nx_check || ny != ny_check || nz != nz_check)
+		{
+			printf("Error! Decompress: nx, ny, nz do not match!\n");
+			printf("nx=%d, ny=%d, nz=%d, nx_check=%d, ny_check=%d, nz_check=%d\n",nx,ny,nz,nx_check,ny_check,nz_check);
+		}
+		assert(nx == nx_check);
+		assert(ny == ny_check);
+		assert(nz == nz_check);
+		if (bx != ((int*)compressed[ivol])[3] || by != ((int*)compressed[ivol])[4] || bz != ((int*)compressed[ivol])[5])
+		{
+			printf("Error! Decompress: streams in a batch must have the same block size!\n");
+		}
+		assert(bx == ((int*)compressed[ivol])[3] && by == ((int*)compressed[ivol])[4] && bz == ((int*)compressed[ivol])[5]);
+		int flags = ((int*)compressed[ivol])[7];
+		int nt_check = (flags & 16) ? ((int*)compressed[ivol])[8] : 1;
+		int bt_check = (flags & 16) ? ((int*)compressed[ivol])[9] : 1;
+		if (nt != nt_check || bt != bt_check)
+		{
+			printf("Error! Decompress: stream has %d snapshots in blocks of %d, expected %d snapshots in blocks of %d! 4D streams need Decompress_4D.\n",nt_check,bt_check,nt,bt);
+		}
+		assert(nt == nt_check && bt == bt_check);
+		if ((flags & 1648) != (((int*)compressed[0])[7] & 1648))
+		{
+			printf("Error! Decompress: streams in a batch must have the same layout!\n");
+		}
+		assert((flags & 1648) == (((int*)compressed[0])[7] & 1648));
+		int nc_check = (flags & 32) ? ((int*)compressed[ivol])[comp_word] : 1;
+		if (nc != nc_check)
+		{
+			printf("Error! Decompress: stream has %d components per sample, expected %d!\n",nc_check,nc);
+		}
+		assert(nc == nc_check);
+	}
+
+	omp_set_num_threads(num_threads);
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	int nbt = (nt+bt-1)/bt;
+	int nnn = nbx*nby*nbz*nbt;
+	long snapshot_stride = (z_fast ? (long)nx*(long)ny*(long)nz : (long)ldx*(long)ldy*(long)nz) * nc;
+	// printf("nbx=%d, nby=%d, nbz=%d, nnn=%d\n",nbx,nby,nbz,nnn);
+
+	float* glob_mulfac = new float[nvol*nm];
+	bool* use_local_RMS = new bool[nvol];
+	bool* reversible = new bool[nvol];
+	bool* compact = new bool[nvol];
+	long* slot_bytes = new long[nvol];
+	float* fill = new float[nvol];
+	unsigned int** index = new unsigned int*[nvol];
+	float** blkmulfac = new float*[nvol];
+	unsigned int** bytes = new unsigned int*[nvol];
+	for (int ivol = 0;  ivol < nvol;  ++ivol)
+	{
+		if (nm > 1)
+			memcpy(glob_mulfac+ivol*nm, compressed[ivol]+mulfac_word, sizeof(float)*nm);
+		else
+			memcpy(glob_mulfac+ivol, compressed[ivol]+6, sizeof(float));
+		int flags = ((int*)compressed[ivol])[7];
+		use_local_RMS[ivol] = (flags & 1) ? true : false;
+		reversible[ivol] = (flags & 2) ? true : false;
+		compact[ivol] = (flags & 128) ? true : false;
+		slot_bytes[ivol] = (flags & 256) ? *((long*)(compressed[ivol]+hdr_words)) : 0l;
+		fill[ivol] = Stream_Fill_Value(compressed[ivol]);
+		// printf("nx=%d, ny=%d, nz=%d, bx=%d, by=%d, bz=%d, mulfac=%e\n",nx,ny,nz,bx,by,bz,glob_mulfac[ivol]);
+
+		index[ivol] = compressed[ivol]+hdr_words;
+		float* after_index = (float*)((char*)index[ivol] + Block_Index_Bytes(nnn,compact[ivol]));
+		if (use_local_RMS[ivol])
+		{
+			blkmulfac[ivol] = after_index;
+			bytes[ivol] = (unsigned int*)(blkmulfac[ivol]+nnn*nm);
+		}
+		else
+		{
+			blkmulfac[ivol] = 0L;
+			bytes[ivol] = (unsigned int*)after_index;
+		}
+	}
+
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,MAX(by,MAX(bz,bt)));
+#undef MAX
+	int blksize = bx*by*bz*bt*nc;
+	int work_size_one_thread = (blksize + max_bs*8);
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	int work_size = work_size_one_thread * num_threads;
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size);
+
+#pragma omp parallel for
+	for (long iGlobBlk = 0;  iGlobBlk < (long)nvol*nnn;  ++iGlobBlk)
+	{
+		int ivol = iGlobBlk / nnn;
+		long iBlk = iGlobBlk - (long)ivol*nnn;
+		long iit = iBlk / (nbx*nby*nbz);
+		long iiz = (iBlk - iit*nbx*nby*nbz) / (nbx*nby);
+		long iix = iBlk - (iit*nbz + iiz)*nbx*nby;
+		long iiy = iix / nbx;
+		iix = iix - iiy*nbx;
+
+		int x0 = iix*bx;
+		int y0 = iiy*by;
+		int z0 = iiz*bz;
+		int t0 = iit*bt;
+		
+		//printf("  iBlk=%d, x0=%d, y0=%d, z0=%d\n",iBlk,x0,y0,z0);
+
+		int thread_id = omp_get_thread_num();
+		float* priv_work = work + thread_id * work_size_one_thread;
+		float* priv_tmp = priv_work + blksize;
+		bool Is_Uncompressed;
+		bool Is_Excluded = false;
+		unsigned long* priv_compressed;
+		const float* mulfac;
+		if (slot_bytes[ivol] > 0)
+		{
+			Is_Uncompressed = false;
+			priv_compressed = Locate_Block(compressed[ivol],iBlk,Is_Uncompressed,mulfac);
+		}
+		else
+		{
+			long priv_blkoff = Get_Block_Offset(index[ivol],nnn,compact[ivol],iBlk);
+			Is_Excluded = (priv_blkoff == -1l);
+			Is_Uncompressed = (priv_blkoff & 0x8000000000000000) ? true : false;
+			priv_blkoff = Is_Uncompressed ? (priv_blkoff & 0x7FFFFFFFFFFFFFFF) : priv_blkoff;
+			priv_compressed = (unsigned long*)(((char*)bytes[ivol]) + priv_blkoff);
+			mulfac = use_local_RMS[ivol] ? blkmulfac[ivol] + iBlk*nm : glob_mulfac + ivol*nm;
+		}
+		//printf("  Is_Uncompressed=%s, priv_blkoff=%ld\n",Is_Uncompressed?"true":"false",priv_blkoff);
+		
+		if (Is_Excluded)
+			for (int i = 0;  i < blksize;  ++i) priv_work[i] = fill[ivol];
+		else
+			Decode_Block(cvx,reversible[ivol],Is_Uncompressed,priv_work,priv_tmp,priv_compressed,bx,by,bz,bt,nc,nm,mulfac);
+		for (int it = 0;  it < bt && t0+it < nt;  ++it)
+		{
+			__m128* priv_snap = (__m128*)(priv_work + it*bx*by*bz);
+			T* snap = vols[ivol] + (t0+it)*snapshot_stride;
+			if (acc != 0L)
+				Accumulate_From_Block(acc,priv_snap,bx,by,bz,snap,(t0+it)*snapshot_stride,x0,y0,z0,nx,ny,nz,ldx,ldy);
+			else if (nc > 1)
+				Copy_From_Block_Interleaved(priv_snap,(long)bt*bx*by*bz,bx,by,bz,snap,nc,x0,y0,z0,nx,ny,nz);
+			else if (z_fast)
+				Copy_From_Block_Z_Fast(priv_snap,bx,by,bz,snap,x0,y0,z0,nx,ny,nz);
+			else
+				Copy_From_Block(priv_snap,bx,by,bz,snap,x0,y0,z0,nx,ny,nz,ldx,ldy);
+		}
+	}
+
+	free(work);
+	delete [] bytes;
+	delete [] blkmulfac;
+	delete [] index;
+	delete [] fill;
+	delete [] slot_bytes;
+	delete [] compact;
+	delete [] reversible;
+	delete [] use_local_RMS;
+	delete [] glob_mulfac;
+}
+
+/*
+ * Decompress a single volume, see Decompress_Volumes.
+ */
+template<typename T>
+static void Decompress_Volume(
+	CvxCompress& cvx,
+	T* vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	bool z_fast,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volumes(cvx,&vol,1,nx,ny,nz,1,1,ldx,ldy,z_fast,0L,false,&compressed,num_threads,&compressed_length);
+}
+
+float* CvxCompress::Decompress(
+	int& nx,
+	int& ny,
+	int& nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	nx = ((int*)compressed)[0];
+	ny = ((int*)compressed)[1];
+	nz = ((int*)compressed)[2];
+	float* vol;
+	posix_memalign((void**)&vol, 64, (long)nx*(long)ny*(long)nz*(long)sizeof(float));
+	Decompress(vol, nx, ny, nz, compressed, compressed_length);
+	return vol;
+}
+
+void CvxCompress::Decompress(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Decompress(vol, nx, ny, nz, compressed, num_threads, compressed_length);
+}
+
+void CvxCompress::Decompress(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	double *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	double *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	cvx_float16 *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	cvx_float16 *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	cvx_bfloat16 *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	cvx_bfloat16 *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	int ox,
+	int oy,
+	int oz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress(vol,nx,ny,nz,ldx,ldy,ox,oy,oz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	int ldx,
+	int ldy,
+	int ox,
+	int oy,
+	int oz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	if (ox < 0 || oy < 0 || oz < 0 || ox+nx > ldx || oy+ny > ldy)
+	{
+		printf("Error! Decompress: region nx=%d, ny=%d at ox=%d, oy=%d, oz=%d does not fit in ldx=%d, ldy=%d\n",nx,ny,ox,oy,oz,ldx,ldy);
+	}
+	assert(ox >= 0 && oy >= 0 && oz >= 0 && ox+nx <= ldx && oy+ny <= ldy);
+	float* origin = vol + ((long)oz * (long)ldy + (long)oy) * (long)ldx + ox;
+	Decompress_Volume(*this,origin,nx,ny,nz,ldx,ldy,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	std::complex<float>* vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress(vol,nx,ny,nz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress(
+	std::complex<float>* vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	float* fvol = (float*)vol;
+	Decompress_Volumes(*this,&fvol,1,nx,ny,nz,1,2,nx,ny,false,0L,false,&compressed,num_threads,&compressed_length);
+}
+
+void CvxCompress::Decompress_Components(
+	float* vol,
+	int nc,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Components(vol,nc,nx,ny,nz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Components(
+	float* vol,
+	int nc,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volumes(*this,&vol,1,nx,ny,nz,1,nc,nx,ny,false,0L,false,&compressed,num_threads,&compressed_length);
+}
+
+void CvxCompress::Decompress_Batch(
+	float* const* vols,
+	int nvol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* const* compressed,
+	const long* compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Batch(vols,nvol,nx,ny,nz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Batch(
+	float* const* vols,
+	int nvol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* const* compressed,
+	int num_threads,
+	const long* compressed_length 
+	)
+{
+	Decompress_Volumes(*this,vols,nvol,nx,ny,nz,1,1,nx,ny,false,0L,false,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Z_Fast(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Z_Fast(vol,nx,ny,nz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Z_Fast(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volume(*this,vol,nx,ny,nz,nx,ny,true,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Accumulate(
+	float* vol,
+	float alpha,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Accumulate(vol,alpha,nx,ny,nz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Accumulate(
+	float* vol,
+	float alpha,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decoded_Accumulation acc;
+	acc.alpha = alpha;
+	acc.src = 0L;
+	Decompress_Volumes(*this,&vol,1,nx,ny,nz,1,1,nx,ny,false,&acc,false,&compressed,num_threads,&compressed_length);
+}
+
+void CvxCompress::Decompress_Multiply_Accumulate(
+	float* img,
+	const float* src,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Multiply_Accumulate(img,src,nx,ny,nz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Multiply_Accumulate(
+	float* img,
+	const float* src,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decoded_Accumulation acc;
+	acc.alpha = 0.0f;
+	acc.src = src;
+	Decompress_Volumes(*this,&img,1,nx,ny,nz,1,1,nx,ny,false,&acc,false,&compressed,num_threads,&compressed_length);
+}
+
+void CvxCompress::Decompress_4D(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_4D(vol,nx,ny,nz,nt,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_4D(
+	float *vol,
+	int nx,
+	int ny,
+	int nz,
+	int nt,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	Decompress_Volumes(*this,&vol,1,nx,ny,nz,nt,1,nx,ny,false,0L,false,&compressed,num_threads,&compressed_length);
+}
+
+void CvxCompress::Decompress_Block(
+	float* blk,
+	int ix,
+	int iy,
+	int iz,
+	unsigned int* compressed
+	)
+{
+	int bx = compressed[3], by = compressed[4], bz = compressed[5];
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,MAX(by,bz));
+#undef MAX
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*(bx*by*bz+max_bs*8));
+	Decompress_Block(blk,ix,iy,iz,compressed,work);
+	free(work);
+}
+
+void CvxCompress::Decompress_Block(
+	float* blk,
+	int ix,
+	int iy,
+	int iz,
+	unsigned int* compressed,
+	float* work
+	)
+{
+	int nt, bt, nc, nm;
+	Stream_Header_Words(compressed,nt,bt,nc,nm);
+	int nx = compressed[0], ny = compressed[1], nz = compressed[2];
+	int bx = compressed[3], by = compressed[4], bz = compressed[5];
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	if (nt != 1 || nc != 1)
+	{
+		printf("Error! Decompress_Block: 4D streams and streams with components are not supported!\n");
+	}
+	assert(nt == 1 && nc == 1);
+	if (compressed[7] & 12)
+	{
+		printf("Error! Decompress_Block: streams from Compress_Delta hold residuals, decompress them with Decompress_Delta!\n");
+	}
+	assert(!(compressed[7] & 12));
+	if (ix < 0 || ix >= nbx || iy < 0 || iy >= nby || iz < 0 || iz >= nbz)
+	{
+		printf("Error! Decompress_Block: block %d,%d,%d is outside the %d x %d x %d blocks of the stream!\n",ix,iy,iz,nbx,nby,nbz);
+	}
+	assert(ix >= 0 && ix < nbx && iy >= 0 && iy < nby && iz >= 0 && iz < nbz);
+	long iBlk = ((long)iz*nby + iy)*nbx + ix;
+	int blksize = bx*by*bz;
+	// the part of the block inside the volume.
+	int ex = nx - ix*bx < bx ? nx - ix*bx : bx;
+	int ey = ny - iy*by < by ? ny - iy*by : by;
+	int ez = nz - iz*bz < bz ? nz - iz*bz : bz;
+	if (compressed[7] & 512)
+	{
+		long* block_offset;
+		unsigned int* first_leaf;
+		unsigned int* leaf_offset;
+		unsigned char* leaf_depth;
+		float* leaf_mulfac;
+		char* bytes;
+		Adaptive_Index(compressed,block_offset,first_leaf,leaf_offset,leaf_depth,leaf_mulfac,bytes);
+		long ileaf0 = first_leaf[iBlk];
+		int* leaf_origin = new int[3*(first_leaf[iBlk+1]-ileaf0)];
+		int nblk_leaf = 0;
+		Walk_Adaptive_Block(leaf_depth+ileaf0,nblk_leaf,0,0,0,0,bx,by,bz,ex,ey,ez,leaf_origin);
+		for (int ileaf = 0;  ileaf < nblk_leaf;  ++ileaf)
+		{
+			int depth = leaf_depth[ileaf0+ileaf];
+			unsigned int rel = leaf_offset[ileaf0+ileaf];
+			char* leaf_bytes = bytes + block_offset[iBlk] + (rel & 0x7FFFFFFF);
+			const float* mulfac = (compressed[7] & 1) ? leaf_mulfac + ileaf0 + ileaf : (const float*)(compressed+6);
+			Decode_Block(*this,false,(rel & 0x80000000) ? true : false,work,work+blksize,(unsigned long*)leaf_bytes,bx>>depth,by>>depth,bz>>depth,1,1,1,mulfac);
+			Copy_From_Block((__m128*)work,bx>>depth,by>>depth,bz>>depth,blk,leaf_origin[3*ileaf],leaf_origin[3*ileaf+1],leaf_origin[3*ileaf+2],ex,ey,ez,bx,by);
+		}
+		delete [] leaf_origin;
+	}
+	else
+	{
+		bool uncompressed;
+		const float* mulfac;
+		unsigned long* priv_compressed = Locate_Block(compressed,iBlk,uncompressed,mulfac);
+		float fill = Stream_Fill_Value(compressed);
+		if (priv_compressed == 0L)
+			for (int i = 0;  i < blksize;  ++i) work[i] = fill;
+		else
+			Decode_Block(*this,(compressed[7] & 2) ? true : false,uncompressed,work,work+blksize,priv_compressed,bx,by,bz,1,1,1,mulfac);
+		Copy_From_Block((__m128*)work,bx,by,bz,blk,0,0,0,ex,ey,ez,bx,by);
+	}
+}
+
+/*
+ * Compress one 2D gather on the calling thread, blocks are encoded in order straight into the output stream.
+ * priv_work must hold bx*by floats, priv_tmp 8*MAX(bx,by) floats and priv_compressed 5/4 of a block.
+ * Returns length of compressed stream in bytes.
+ */
+static long Compress_Gather(
+	CvxCompress& cvx,
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int bx,
+	int by,
+	bool use_local_RMS,
+	unsigned int* compressed,
+	float* priv_work,
+	float* priv_tmp,
+	unsigned long* priv_compressed
+	)
+{
+	float global_rms = use_local_RMS ? 1.0f : Compute_Global_RMS(vol,nx,ny,1);
+	float glob_mulfac = global_rms != 0.0f ? 1.0f / (global_rms * scale) : 1.0f;
+	glob_mulfac = !isfinite(glob_mulfac) ? 1.0f : glob_mulfac;
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nnn = nbx*nby;
+
+	compressed[0] = nx;
+	compressed[1] = ny;
+	compressed[2] = 1;
+	compressed[3] = bx;
+	compressed[4] = by;
+	compressed[5] = 1;
+	memcpy(compressed+6, &glob_mulfac, sizeof(float));
+	compressed[7] = use_local_RMS ? 1 : 0;
+
+	long index_bytes = Reserved_Index_Bytes(nnn);
+	long* glob_blkoffs = new long[nnn];
+	char* after_index = (char*)(compressed+8) + index_bytes;
+	float* blkmulfac = use_local_RMS ? (float*)after_index : 0L;
+	char* bytes = use_local_RMS ? (char*)(blkmulfac+nnn) : after_index;
+	long byte_offset = 0l;
+	for (int iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		int iiy = iBlk / nbx;
+		int iix = iBlk - iiy*nbx;
+		Copy_To_Block(vol,iix*bx,iiy*by,0,nx,ny,1,(__m128*)priv_work,bx,by,1);
+		float mulfac = glob_mulfac;
+		bool uncompressed = false;
+		int bytepos = Encode_Block(cvx,scale,false,0.0f,use_local_RMS,priv_work,priv_tmp,priv_compressed,bx,by,1,1,1,1,&mulfac,uncompressed);
+		if (use_local_RMS) blkmulfac[iBlk] = mulfac;
+		memcpy(bytes+byte_offset,priv_compressed,bytepos);
+		glob_blkoffs[iBlk] = uncompressed ? (byte_offset | 0x8000000000000000) : byte_offset;
+		byte_offset += bytepos;
+	}
+	long compressed_length = 32 + index_bytes + byte_offset + 7;
+	if (use_local_RMS) compressed_length += 4*nnn;
+	Write_Block_Index(compressed,glob_blkoffs,compressed_length);
+	delete [] glob_blkoffs;
+	return compressed_length;
+}
+
+/*
+ * Decompress one 2D gather on the calling thread. Workspace requirements are the same as for Compress_Gather.
+ */
+static void Decompress_Gather(
+	CvxCompress& cvx,
+	float* vol,
+	int nx,
+	int ny,
+	unsigned int* compressed,
+	float* priv_work,
+	float* priv_tmp
+	)
+{
+	int bx = ((int*)compressed)[3];
+	int by = ((int*)compressed)[4];
+	bool reversible = (compressed[7] & 2) ? true : false;
+	float fill = Stream_Fill_Value(compressed);
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nnn = nbx*nby;
+
+	for (int iBlk = 0;  iBlk < nnn;  ++iBlk)
+	{
+		int iiy = iBlk / nbx;
+		int iix = iBlk - iiy*nbx;
+		// Locate_Block knows where the index ends and how fixed size streams store their blocks.
+		bool uncompressed;
+		const float* mulfac;
+		unsigned long* priv_compressed = Locate_Block(compressed,iBlk,uncompressed,mulfac);
+		if (priv_compressed == 0L)
+			for (int i = 0;  i < bx*by;  ++i) priv_work[i] = fill;
+		else
+			Decode_Block(cvx,reversible,uncompressed,priv_work,priv_tmp,priv_compressed,bx,by,1,1,1,1,mulfac);
+		Copy_From_Block((__m128*)priv_work,bx,by,1,vol,iix*bx,iiy*by,0,nx,ny,1);
+	}
+}
+
+float CvxCompress::Compress_Gathers(
+	float scale,
+	const float* const* gathers,
+	int ngathers,
+	int nx,
+	int ny,
+	int bx,
+	int by,
+	bool use_local_RMS,
+	unsigned int* const* compressed,
+	long* compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Gathers(scale,gathers,ngathers,nx,ny,bx,by,use_local_RMS,compressed,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Gathers(
+	float scale,
+	const float* const* gathers,
+	int ngathers,
+	int nx,
+	int ny,
+	int bx,
+	int by,
+	bool use_local_RMS,
+	unsigned int* const* compressed,
+	int num_threads,
+	long* compressed_length
+	)
+{
+	assert(Is_Valid_Block_Size(bx,by,1));
+	omp_set_num_threads(num_threads);
+
+#define MAX(a,b) (a>b?a:b)
+	int max_bs = MAX(bx,by);
+#undef MAX
+	long work_size_one_thread = (long)bx*by + 8*max_bs + ((5*bx*by) >> 2) + 64;
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+
+	long total_length = 0l;
+#pragma omp parallel for schedule(dynamic) reduction(+:total_length)
+	for (int i = 0;  i < ngathers;  ++i)
+	{
+		int thread_id = omp_get_thread_num();
+		float* priv_work = work + thread_id * work_size_one_thread;
+		float* priv_tmp = priv_work + bx*by;
+		unsigned long* priv_compressed = (unsigned long*)(priv_tmp + 8*max_bs);
+		compressed_length[i] = Compress_Gather(*this,scale,(float*)gathers[i],nx,ny,bx,by,use_local_RMS,compressed[i],priv_work,priv_tmp,priv_compressed);
+		total_length += compressed_length[i];
+	}
+
+	free(work);
+	double ratio = ((double)nx * (double)ny * (double)ngathers * 4.0) / (double)total_length;
+	return (float)ratio;
+}
+
+void CvxCompress::Decompress_Gathers(
+	float* const* gathers,
+	int ngathers,
+	int nx,
+	int ny,
+	unsigned int* const* compressed,
+	const long* compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Gathers(gathers,ngathers,nx,ny,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Gathers(
+	float* const* gathers,
+	int ngathers,
+	int nx,
+	int ny,
+	unsigned int* const* compressed,
+	int num_threads,
+	const long* compressed_length
+	)
+{
+	int max_bs = 0, max_blk = 0;
+	for (int i = 0;  i < ngathers;  ++i)
+	{
+		int* hdr = (int*)compressed[i];
+		if (hdr[0] != nx || hdr[1] != ny || hdr[2] != 1)
+		{
+			printf("Error! Decompress_Gathers: gather %d is %d x %d x %d, expected %d x %d x 1\n",i,hdr[0],hdr[1],hdr[2],nx,ny);
+		}
+		assert(hdr[0] == nx && hdr[1] == ny && hdr[2] == 1);
+		// delta, 4D, component and adaptive streams need their own Decompress methods.
+		if (hdr[7] & (4|8|16|32|64|512))
+		{
+			printf("Error! Decompress_Gathers: gather %d has stream flags %d, only plain, fixed size and masked 2D streams can be decoded\n",i,hdr[7]);
+		}
+		assert(!(hdr[7] & (4|8|16|32|64|512)));
+		if (hdr[3] > max_bs) max_bs = hdr[3];
+		if (hdr[4] > max_bs) max_bs = hdr[4];
+		if (hdr[3]*hdr[4] > max_blk) max_blk = hdr[3]*hdr[4];
+	}
+	omp_set_num_threads(num_threads);
+
+	long work_size_one_thread = (long)max_blk + 8*max_bs;
+	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
+	float* work;
+	posix_memalign((void**)&work, 64, sizeof(float)*work_size_one_thread*num_threads);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0;  i < ngathers;  ++i)
+	{
+		int thread_id = omp_get_thread_num();
+		float* priv_work = work + thread_id * work_size_one_thread;
+		float* priv_tmp = priv_work + max_blk;
+		Decompress_Gather(*this,gathers[i],nx,ny,compressed[i],priv_work,priv_tmp);
+	}
+
+	free(work);
+}
+
+/*
+ * Prediction of a snapshot from the decoded previous snapshots of a sequence.
+ * prev2 == 0L predicts prev, otherwise the linear extrapolation 2*prev-prev2.
+ * Encoder and decoder both reconstruct with Add_Prediction, so their reference frames are bit identical.
+ */
+static void Subtract_Prediction(float* residual, const float* vol, const float* prev, const float* prev2, long nn)
+{
+	if (prev2 == 0L)
+	{
+#pragma omp parallel for schedule(static)
+		for (long i = 0;  i < nn;  ++i) residual[i] = vol[i] - prev[i];
+	}
+	else
+	{
+#pragma omp parallel for schedule(static)
+		for (long i = 0;  i < nn;  ++i) residual[i] = vol[i] - (2.0f * prev[i] - prev2[i]);
+	}
+}
+
+static void Add_Prediction(float* vol, const float* prev, const float* prev2, long nn)
+{
+	if (prev2 == 0L)
+	{
+#pragma omp parallel for schedule(static)
+		for (long i = 0;  i < nn;  ++i) vol[i] = vol[i] + prev[i];
+	}
+	else
+	{
+#pragma omp parallel for schedule(static)
+		for (long i = 0;  i < nn;  ++i) vol[i] = vol[i] + (2.0f * prev[i] - prev2[i]);
+	}
+}
+
+float CvxCompress::Compress_Delta(
+	float scale,
+	float* vol,
+	const float* prev,
+	const float* prev2,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	unsigned int* compressed,
+	float* decoded,
+	long& compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Delta(scale,vol,prev,prev2,nx,ny,nz,bx,by,bz,compressed,decoded,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Delta(
+	float scale,
+	float* vol,
+	const float* prev,
+	const float* prev2,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	unsigned int* compressed,
+	float* decoded,
+	int num_threads,
+	long& compressed_length 
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_Delta(scale,vol,prev,prev2,nx,ny,nz,bx,by,bz,global_rms,compressed,decoded,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Delta(
+	float scale,
+	float* vol,
+	const float* prev,
+	const float* prev2,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	float& global_rms,
+	unsigned int* compressed,
+	float* decoded,
+	long& compressed_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Delta(scale,vol,prev,prev2,nx,ny,nz,bx,by,bz,global_rms,compressed,decoded,num_threads,compressed_length);
+}
+
+float CvxCompress::Compress_Delta(
+	float scale,
+	float* vol,
+	const float* prev,
+	const float* prev2,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	float& global_rms,
+	unsigned int* compressed,
+	float* decoded,
+	int num_threads,
+	long& compressed_length
+	)
+{
+	if (prev == 0L)
+	{
+		// key frame, a regular stream.
+		float ratio = Compress(scale,vol,nx,ny,nz,bx,by,bz,false,global_rms,compressed,num_threads,compressed_length);
+		if (decoded != 0L) Decompress(decoded,nx,ny,nz,compressed,num_threads,compressed_length);
+		return ratio;
+	}
+
+	// threshold is relative to the RMS of the snapshot, not the residual, so all frames have the same quality.
+	omp_set_num_threads(num_threads);
+	long nn = (long)nx * (long)ny * (long)nz;
+	if (global_rms <= 0.0f) global_rms = Compute_Global_RMS(vol,nx,ny,nz);
+	float* residual = decoded;
+	if (residual == 0L) posix_memalign((void**)&residual, 64, sizeof(float)*nn);
+	Subtract_Prediction(residual,vol,prev,prev2,nn);
+	// a copy, so the RMS of the residual of an all zero snapshot is not returned as the RMS of the snapshot.
+	float quant_rms = global_rms;
+	float ratio = Compress_Volumes(*this,&scale,1,false,0.0f,&residual,1,nx,ny,nz,1,1,false,nx,ny,false,bx,by,bz,1,false,&quant_rms,0L,0L,&compressed,num_threads,&compressed_length);
+	compressed[7] |= (prev2 != 0L ? 8 : 4);
+	if (decoded != 0L)
+	{
+		Decompress_Delta(decoded,prev,prev2,nx,ny,nz,compressed,num_threads,compressed_length);
+	}
+	else
+	{
+		free(residual);
+	}
+	return ratio;
+}
+
+void CvxCompress::Decompress_Delta(
+	float* vol,
+	const float* prev,
+	const float* prev2,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	long compressed_length 
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Delta(vol,prev,prev2,nx,ny,nz,compressed,num_threads,compressed_length);
+}
+
+void CvxCompress::Decompress_Delta(
+	float* vol,
+	const float* prev,
+	const float* prev2,
+	int nx,
+	int ny,
+	int nz,
+	unsigned int* compressed,
+	int num_threads,
+	long compressed_length 
+	)
+{
+	// flags:
+	// 4 -> residual against previous snapshot
+	// 8 -> residual against linear extrapolation from the two previous snapshots
+	int flags = ((int*)compressed)[7];
+	int order = (flags & 8) ? 2 : ((flags & 4) ? 1 : 0);
+	if ((order >= 1 && prev == 0L) || (order >= 2 && prev2 == 0L))
+	{
+		printf("Error! Decompress_Delta: stream is predicted from %d previous snapshot(s), but they were not supplied!\n",order);
+	}
+	assert(order < 1 || prev != 0L);
+	assert(order < 2 || prev2 != 0L);
+	Decompress_Volumes(*this,&vol,1,nx,ny,nz,1,1,nx,ny,false,0L,true,&compressed,num_threads,&compressed_length);
+	if (order > 0)
+	{
+		omp_set_num_threads(num_threads);
+		Add_Prediction(vol,prev,order == 2 ? prev2 : 0L,(long)nx * (long)ny * (long)nz);
+	}
+}
+
+float CvxCompress::Axpy_Compressed(
+	float alpha,
+	unsigned int* A,
+	long A_length,
+	float beta,
+	unsigned int* B,
+	long B_length,
+	float scale,
+	bool use_local_RMS,
+	unsigned int* C,
+	long& C_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Axpy_Compressed(alpha,A,A_length,beta,B,B_length,scale,use_local_RMS,C,num_threads,C_length);
+}
+
+float CvxCompress::Axpy_Compressed(
+	float alpha,
+	unsigned int* A,
+	long A_length,
+	float beta,
+	unsigned int* B,
+	long B_length,
+	float scale,
+	bool use_local_RMS,
+	unsigned int* C,
+	int num_threads,
+	long& C_length
+	)
+{
+	float global_rms = 0.0f;
+	return Axpy_Compressed(alpha,A,A_length,beta,B,B_length,scale,use_local_RMS,global_rms,C,num_threads,C_length);
+}
+
+float CvxCompress::Axpy_Compressed(
+	float alpha,
+	unsigned int* A,
+	long A_length,
+	float beta,
+	unsigned int* B,
+	long B_length,
+	float scale,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* C,
+	long& C_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Axpy_Compressed(alpha,A,A_length,beta,B,B_length,scale,use_local_RMS,global_rms,C,num_threads,C_length);
+}
+
+float CvxCompress::Axpy_Compressed(
+	float alpha,
+	unsigned int* A,
+	long A_length,
+	float beta,
+	unsigned int* B,
+	long B_length,
+	float scale,
+	bool use_local_RMS,
+	float& global_rms,
+	unsigned int* C,
+	int num_threads,
+	long& C_length
+	)
+{
+	Check_Compressed_Operands("Axpy_Compressed",A,B,false);
+	int nt, bt, nc, nm;
+	Stream_Header_Words(A,nt,bt,nc,nm);
+
+	unsigned int* streams[2] = {A, B};
+	float weights[2] = {alpha, beta};
+	Compressed_Sum sum = {2, streams, weights};
+	float* sum_rms = new float[nm];
+	if (!use_local_RMS)
+	{
+		if (nm == 1 && global_rms > 0.0f)
+		{
+			sum_rms[0] = global_rms;
+		}
+		else
+		{
+			Estimate_Sum_RMS(sum,num_threads,sum_rms);
+			if (nm == 1) global_rms = sum_rms[0];
+		}
+	}
+	float ratio = Compress_Volumes(*this,&scale,1,false,0.0f,(float* const*)0L,1,A[0],A[1],A[2],nt,nc,nm > 1,A[0],A[1],false,A[3],A[4],A[5],bt,use_local_RMS,sum_rms,&sum,0L,&C,num_threads,&C_length);
+	delete [] sum_rms;
+	return ratio;
+}
+
+float CvxCompress::Transcode(
+	float new_scale,
+	unsigned int* compressed_in,
+	long in_length,
+	unsigned int* compressed_out,
+	long& out_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Transcode(new_scale,compressed_in,in_length,compressed_out,num_threads,out_length);
+}
+
+float CvxCompress::Transcode(
+	float new_scale,
+	unsigned int* compressed_in,
+	long in_length,
+	unsigned int* compressed_out,
+	int num_threads,
+	long& out_length
+	)
+{
+	float global_rms = 0.0f;
+	return Transcode(new_scale,compressed_in,in_length,global_rms,compressed_out,num_threads,out_length);
+}
+
+float CvxCompress::Transcode(
+	float new_scale,
+	unsigned int* compressed_in,
+	long in_length,
+	float& global_rms,
+	unsigned int* compressed_out,
+	long& out_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Transcode(new_scale,compressed_in,in_length,global_rms,compressed_out,num_threads,out_length);
+}
+
+float CvxCompress::Transcode(
+	float new_scale,
+	unsigned int* compressed_in,
+	long in_length,
+	float& global_rms,
+	unsigned int* compressed_out,
+	int num_threads,
+	long& out_length
+	)
+{
+	Check_Compressed_Operands("Transcode",compressed_in,compressed_in,false);
+	int nt, bt, nc, nm;
+	Stream_Header_Words(compressed_in,nt,bt,nc,nm);
+	bool use_local_RMS = (compressed_in[7] & 1) ? true : false;
+
+	unsigned int* streams[1] = {compressed_in};
+	float weights[1] = {1.0f};
+	Compressed_Sum sum = {1, streams, weights};
+	float* sum_rms = new float[nm];
+	if (!use_local_RMS)
+	{
+		if (nm == 1 && global_rms > 0.0f)
+		{
+			sum_rms[0] = global_rms;
+		}
+		else
+		{
+			Estimate_Sum_RMS(sum,num_threads,sum_rms);
+			if (nm == 1) global_rms = sum_rms[0];
+		}
+	}
+	unsigned int* A = compressed_in;
+	float ratio = Compress_Volumes(*this,&new_scale,1,false,0.0f,(float* const*)0L,1,A[0],A[1],A[2],nt,nc,nm > 1,A[0],A[1],false,A[3],A[4],A[5],bt,use_local_RMS,sum_rms,&sum,0L,&compressed_out,num_threads,&out_length);
+	delete [] sum_rms;
+	return ratio;
+}
+
+float CvxCompress::Stitch_Compressed(
+	unsigned int* const* pieces,
+	const long* piece_length,
+	const int* x0,
+	const int* y0,
+	const int* z0,
+	int npiece,
+	int nx,
 	int ny,
 	int nz,
 	unsigned int* compressed,
-	long compressed_length 
+	long& compressed_length
 	)
 {
 	int num_threads;
@@ -457,117 +5036,482 @@ void CvxCompress::Decompress(
 	{
 		num_threads = omp_get_num_threads();
 	}
-	return Decompress(vol, nx, ny, nz, compressed, num_threads, compressed_length);
+	return Stitch_Compressed(pieces,piece_length,x0,y0,z0,npiece,nx,ny,nz,compressed,num_threads,compressed_length);
 }
 
-void CvxCompress::Decompress(
-	float *vol,
+float CvxCompress::Stitch_Compressed(
+	unsigned int* const* pieces,
+	const long* piece_length,
+	const int* x0,
+	const int* y0,
+	const int* z0,
+	int npiece,
 	int nx,
 	int ny,
 	int nz,
 	unsigned int* compressed,
 	int num_threads,
-	long compressed_length 
+	long& compressed_length
 	)
 {
-	int nx_check = ((int*)compressed)[0];
-	int ny_check = ((int*)compressed)[1];
-	int nz_check = ((int*)compressed)[2];
-	// Check sizes and print error message if they don't match.
-	// for nx ny and nz
-	if (nx != nx_check || ny != ny_check || nz != nz_check)
+	if (npiece < 1)
+	{
+		printf("Error! Stitch_Compressed: need at least one piece!\n");
+	}
+	assert(npiece >= 1);
+	unsigned int* P0 = pieces[0];
+	int nt, bt, nc, nm;
+	int hdr_words = Stream_Header_Words(P0,nt,bt,nc,nm);
+	int bx = P0[3], by = P0[4], bz = P0[5];
+	int flags = P0[7] & ~129;
+	if (flags & 1792)
+	{
+		printf("Error! Stitch_Compressed: fixed size, adaptive and masked pieces are not supported!\n");
+	}
+	assert(!(flags & 1792));
+	// global factors live in word 6, or in the table at the end of the header if every component has its own.
+	int glob_mulfac_word = nm > 1 ? hdr_words - ((nm+1) & ~1) : 6;
+
+	// pieces with different global factors are merged by storing the factors of every block, like local RMS streams.
+	bool use_local_RMS = false;
+	for (int ip = 0;  ip < npiece;  ++ip)
+	{
+		unsigned int* P = pieces[ip];
+		int ntP, btP, ncP, nmP;
+		Stream_Header_Words(P,ntP,btP,ncP,nmP);
+		bool same_layout = P[3] == bx && P[4] == by && P[5] == bz && (P[7] & ~129) == flags && ntP == nt && btP == bt && ncP == nc;
+		if (!same_layout)
+		{
+			printf("Error! Stitch_Compressed: piece %d does not have the block size and layout of piece 0!\n",ip);
+		}
+		assert(same_layout);
+		int pnx = P[0], pny = P[1], pnz = P[2];
+		bool aligned = 
+			x0[ip] >= 0 && y0[ip] >= 0 && z0[ip] >= 0 &&
+			(x0[ip] % bx) == 0 && (y0[ip] % by) == 0 && (z0[ip] % bz) == 0 &&
+			x0[ip]+pnx <= nx && y0[ip]+pny <= ny && z0[ip]+pnz <= nz &&
+			((pnx % bx) == 0 || x0[ip]+pnx == nx) && ((pny % by) == 0 || y0[ip]+pny == ny) && ((pnz % bz) == 0 || z0[ip]+pnz == nz);
+		if (!aligned)
+		{
+			printf("Error! Stitch_Compressed: piece %d (%d x %d x %d at %d,%d,%d) is not aligned with the %d x %d x %d blocks of the %d x %d x %d volume!\n",
+				ip,pnx,pny,pnz,x0[ip],y0[ip],z0[ip],bx,by,bz,nx,ny,nz);
+		}
+		assert(aligned);
+		if (P[7] & 1)
+			use_local_RMS = true;
+		else if (memcmp(P+glob_mulfac_word,P0+glob_mulfac_word,sizeof(float)*nm) != 0)
+			use_local_RMS = true;
+	}
+	if (use_local_RMS && (flags & 2))
+	{
+		printf("Error! Stitch_Compressed: reversible pieces must have the same quantization step!\n");
+	}
+	assert(!use_local_RMS || !(flags & 2));
+
+	int nbx = (nx+bx-1)/bx;
+	int nby = (ny+by-1)/by;
+	int nbz = (nz+bz-1)/bz;
+	int nbt = (nt+bt-1)/bt;
+	long nnn = (long)nbx*nby*nbz*nbt;
+
+	// every block of the volume must come from exactly one piece.
+	char* filled = new char[nnn];
+	memset(filled,0,nnn);
+	long* payload_offset = new long[npiece+1];
+	payload_offset[0] = 0l;
+	bool tiled = true;
+	for (int ip = 0;  ip < npiece;  ++ip)
+	{
+		unsigned int* P = pieces[ip];
+		int pnbx = (P[0]+bx-1)/bx, pnby = (P[1]+by-1)/by, pnbz = (P[2]+bz-1)/bz;
+		int ox = x0[ip]/bx, oy = y0[ip]/by, oz = z0[ip]/bz;
+		for (int it = 0;  it < nbt;  ++it)
+			for (int iz = 0;  iz < pnbz;  ++iz)
+				for (int iy = 0;  iy < pnby;  ++iy)
+					for (int ix = 0;  ix < pnbx;  ++ix)
+					{
+						long iBlk = (((long)it*nbz + oz+iz)*nby + oy+iy)*nbx + ox+ix;
+						tiled = tiled && !filled[iBlk];
+						filled[iBlk] = 1;
+					}
+		long pnnn = Stream_Num_Blocks(P);
+		long payload_length = piece_length[ip] - 7 - 4*hdr_words - Block_Index_Bytes(pnnn,(P[7] & 128) != 0) - ((P[7] & 1) ? 4*pnnn*nm : 0);
+		if (payload_length < 0)
+		{
+			printf("Error! Stitch_Compressed: piece %d is shorter than its header and block index!\n",ip);
+		}
+		assert(payload_length >= 0);
+		payload_offset[ip+1] = payload_offset[ip] + payload_length;
+	}
+	for (long iBlk = 0;  iBlk < nnn;  ++iBlk) tiled = tiled && filled[iBlk];
+	if (!tiled)
+	{
+		printf("Error! Stitch_Compressed: pieces must cover the volume without overlapping!\n");
+	}
+	assert(tiled);
+	delete [] filled;
+
+	compressed_length = 4*hdr_words + 8*nnn + (use_local_RMS ? 4*nnn*nm : 0) + payload_offset[npiece] + 7;
+	double ratio = ((double)nx * (double)ny * (double)nz * (double)nt * (double)nc * (double)sizeof(float)) / (double)compressed_length;
+	if (compressed == 0L)
 	{
-		printf("Error! Decompress: nx, ny, nz do not match!\n");
-		printf("nx=%d, ny=%d, nz=%d, nx_check=%d, ny_check=%d, nz_check=%d\n",nx,ny,nz,nx_check,ny_check,nz_check);
+		delete [] payload_offset;
+		return (float)ratio;
 	}
 
+	memcpy(compressed,P0,sizeof(int)*hdr_words);
+	compressed[0] = nx;
+	compressed[1] = ny;
+	compressed[2] = nz;
+	compressed[7] = flags | (use_local_RMS ? 1 : 0);
+	// the size above has room for the 8 byte index, the stream is laid out for the compact one, see Write_Block_Index.
+	long index_bytes = Reserved_Index_Bytes(nnn);
+	compressed_length -= 8*nnn - index_bytes;
+	long* glob_blkoffs = new long[nnn];
+	float* blkmulfac = (float*)((char*)(compressed+hdr_words) + index_bytes);
+	char* bytes = (char*)(use_local_RMS ? (void*)(blkmulfac+nnn*nm) : (void*)blkmulfac);
+
+	// only the block index is rewritten, the encoded blocks are copied as they are.
 	omp_set_num_threads(num_threads);
+#pragma omp parallel for schedule(dynamic)
+	for (int ip = 0;  ip < npiece;  ++ip)
+	{
+		unsigned int* P = pieces[ip];
+		int ntP, btP, ncP, nmP;
+		int P_hdr_words = Stream_Header_Words(P,ntP,btP,ncP,nmP);
+		long pnnn = Stream_Num_Blocks(P);
+		bool P_local_RMS = (P[7] & 1) ? true : false;
+		bool P_compact = (P[7] & 128) ? true : false;
+		const unsigned int* P_index = P+P_hdr_words;
+		float* P_blkmulfac = (float*)((char*)P_index + Block_Index_Bytes(pnnn,P_compact));
+		char* P_bytes = (char*)(P_local_RMS ? (void*)(P_blkmulfac+pnnn*nm) : (void*)P_blkmulfac);
+		int pnbx = (P[0]+bx-1)/bx, pnby = (P[1]+by-1)/by, pnbz = (P[2]+bz-1)/bz;
+		int ox = x0[ip]/bx, oy = y0[ip]/by, oz = z0[ip]/bz;
+		long iPBlk = 0;
+		for (int it = 0;  it < nbt;  ++it)
+			for (int iz = 0;  iz < pnbz;  ++iz)
+				for (int iy = 0;  iy < pnby;  ++iy)
+					for (int ix = 0;  ix < pnbx;  ++ix, ++iPBlk)
+					{
+						long iBlk = (((long)it*nbz + oz+iz)*nby + oy+iy)*nbx + ox+ix;
+						// adding a positive base leaves the uncompressed flag in the high bit alone.
+						glob_blkoffs[iBlk] = Get_Block_Offset(P_index,pnnn,P_compact,iPBlk) + payload_offset[ip];
+						if (use_local_RMS)
+						{
+							const float* mulfac = P_local_RMS ? P_blkmulfac + iPBlk*nm : (const float*)(P + glob_mulfac_word);
+							for (int im = 0;  im < nm;  ++im) blkmulfac[iBlk*nm+im] = mulfac[im];
+						}
+					}
+		memcpy(bytes+payload_offset[ip],P_bytes,payload_offset[ip+1]-payload_offset[ip]);
+	}
+	Write_Block_Index(compressed,glob_blkoffs,compressed_length);
 
-	assert(nx == nx_check);
-	assert(ny == ny_check);
-	assert(nz == nz_check);
+	delete [] glob_blkoffs;
+	delete [] payload_offset;
+	ratio = ((double)nx * (double)ny * (double)nz * (double)nt * (double)nc * (double)sizeof(float)) / (double)compressed_length;
+	return (float)ratio;
+}
 
-	int bx = ((int*)compressed)[3];
-	int by = ((int*)compressed)[4];
-	int bz = ((int*)compressed)[5];
-	float glob_mulfac = ((float*)compressed)[6];
-	int flags = ((int*)compressed)[7];
-	bool use_local_RMS = (flags & 1) ? true : false;
-	// printf("nx=%d, ny=%d, nz=%d, bx=%d, by=%d, bz=%d, mulfac=%e\n",nx,ny,nz,bx,by,bz,glob_mulfac);
+float CvxCompress::Compress_Shards(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	int nshard,
+	unsigned int* const* shards,
+	long* shard_length,
+	long* manifest
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Shards(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,nshard,shards,num_threads,shard_length,manifest);
+}
 
-	int nbx = (nx+bx-1)/bx;
-	int nby = (ny+by-1)/by;
+float CvxCompress::Compress_Shards(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	int nshard,
+	unsigned int* const* shards,
+	int num_threads,
+	long* shard_length,
+	long* manifest
+	)
+{
+	float global_rms = 0.0f;
+	return Compress_Shards(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,nshard,shards,num_threads,shard_length,manifest);
+}
+
+float CvxCompress::Compress_Shards(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	int nshard,
+	unsigned int* const* shards,
+	long* shard_length,
+	long* manifest
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Compress_Shards(scale,vol,nx,ny,nz,bx,by,bz,use_local_RMS,global_rms,nshard,shards,num_threads,shard_length,manifest);
+}
+
+float CvxCompress::Compress_Shards(
+	float scale,
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	int bx,
+	int by,
+	int bz,
+	bool use_local_RMS,
+	float& global_rms,
+	int nshard,
+	unsigned int* const* shards,
+	int num_threads,
+	long* shard_length,
+	long* manifest
+	)
+{
 	int nbz = (nz+bz-1)/bz;
-	int nnn = nbx*nby*nbz;
-	// printf("nbx=%d, nby=%d, nbz=%d, nnn=%d\n",nbx,nby,nbz,nnn);
+	if (nshard < 1 || nshard > nbz)
+	{
+		printf("Error! Compress_Shards: nshard must be between 1 and the number of block layers along z (%d), got %d!\n",nbz,nshard);
+	}
+	assert(nshard >= 1 && nshard <= nbz);
+	// all shards are quantized against the RMS of the whole volume, so they have the same quality as one stream would.
+	if (!use_local_RMS && global_rms <= 0.0f)
+	{
+		omp_set_num_threads(num_threads);
+		global_rms = Compute_Global_RMS(vol,nx,ny,nz);
+	}
+	// manifest:
+	// nx, ny, nz, nshard, then first z slice, number of z slices and stream length of every shard.
+	manifest[0] = nx;
+	manifest[1] = ny;
+	manifest[2] = nz;
+	manifest[3] = nshard;
+	long total_length = 0l;
+	for (int ishard = 0;  ishard < nshard;  ++ishard)
+	{
+		// shards hold whole layers of blocks, so every shard is the regular stream of an nx*ny slab of the volume.
+		int z0 = (int)(((long)nbz*ishard/nshard) * bz);
+		int z1 = (int)(((long)nbz*(ishard+1)/nshard) * bz);
+		z1 = z1 < nz ? z1 : nz;
+		float* slab = vol + (long)z0*(long)nx*(long)ny;
+		Compress_Volumes(*this,&scale,1,false,0.0f,&slab,1,nx,ny,z1-z0,1,1,false,nx,ny,false,bx,by,bz,1,use_local_RMS,&global_rms,0L,0L,&shards[ishard],num_threads,&shard_length[ishard]);
+		manifest[4+3*ishard] = z0;
+		manifest[5+3*ishard] = z1-z0;
+		manifest[6+3*ishard] = shard_length[ishard];
+		total_length += shard_length[ishard];
+	}
+	double ratio = ((double)nx * (double)ny * (double)nz * (double)sizeof(float)) / (double)total_length;
+	return (float)ratio;
+}
 
-	long* glob_blkoffs = (long*)(compressed+8);
+void CvxCompress::Decompress_Shard(
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	const long* manifest,
+	int ishard,
+	unsigned int* shard,
+	long shard_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	Decompress_Shard(vol,nx,ny,nz,manifest,ishard,shard,num_threads,shard_length);
+}
 
-	float* blkmulfac = 0L;
-	unsigned int* bytes;
-	if (use_local_RMS)
+void CvxCompress::Decompress_Shard(
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	const long* manifest,
+	int ishard,
+	unsigned int* shard,
+	int num_threads,
+	long shard_length
+	)
+{
+	if (manifest[0] != nx || manifest[1] != ny || manifest[2] != nz || ishard < 0 || ishard >= manifest[3])
 	{
-		blkmulfac = (float*)(glob_blkoffs+nnn);
-		bytes = (unsigned int*)(blkmulfac+nnn);
+		printf("Error! Decompress_Shard: manifest is for %ld x %ld x %ld with %ld shards, asked for shard %d of %d x %d x %d!\n",
+			manifest[0],manifest[1],manifest[2],manifest[3],ishard,nx,ny,nz);
 	}
-	else
+	assert(manifest[0] == nx && manifest[1] == ny && manifest[2] == nz && ishard >= 0 && ishard < manifest[3]);
+	long z0 = manifest[4+3*ishard];
+	int shard_nz = (int)manifest[5+3*ishard];
+	Decompress(vol+z0*(long)nx*(long)ny,nx,ny,shard_nz,shard,num_threads,shard_length);
+}
+
+void CvxCompress::Decompress_Shards(
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	const long* manifest,
+	unsigned int* const* shards,
+	const long* shard_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
 	{
-		blkmulfac = 0L;
-		bytes = (unsigned int*)(glob_blkoffs+nnn);
+		num_threads = omp_get_num_threads();
 	}
+	Decompress_Shards(vol,nx,ny,nz,manifest,shards,num_threads,shard_length);
+}
 
-#define MAX(a,b) (a>b?a:b)
-	int max_bs = MAX(bx,MAX(by,bz));
-#undef MAX
-	int work_size_one_thread = ((bx*by*bz) + max_bs*8);
-	work_size_one_thread = (((work_size_one_thread + 15 ) >> 4) << 4);  // round to full 64b page
-	int work_size = work_size_one_thread * num_threads;
-	float* work;
-	posix_memalign((void**)&work, 64, sizeof(float)*work_size);
+void CvxCompress::Decompress_Shards(
+	float* vol,
+	int nx,
+	int ny,
+	int nz,
+	const long* manifest,
+	unsigned int* const* shards,
+	int num_threads,
+	const long* shard_length
+	)
+{
+	for (int ishard = 0;  ishard < (int)manifest[3];  ++ishard)
+		Decompress_Shard(vol,nx,ny,nz,manifest,ishard,shards[ishard],num_threads,shard_length[ishard]);
+}
 
-#pragma omp parallel for
-	for (long iBlk = 0;  iBlk < nnn;  ++iBlk)
+double CvxCompress::Dot_Compressed(
+	unsigned int* A,
+	long A_length,
+	unsigned int* B,
+	long B_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
 	{
-		long iiz = iBlk / (nbx*nby);
-		long iix = iBlk - iiz*nbx*nby;
-		long iiy = iix / nbx;
-		iix = iix - iiy*nbx;
+		num_threads = omp_get_num_threads();
+	}
+	return Dot_Compressed(A,A_length,B,B_length,num_threads);
+}
+
+double CvxCompress::Dot_Compressed(
+	unsigned int* A,
+	long A_length,
+	unsigned int* B,
+	long B_length,
+	int num_threads
+	)
+{
+	Check_Compressed_Operands("Dot_Compressed",A,B,false);
+	return Estimate_Dot_Blocks(A,B,num_threads,0L);
+}
+
+double CvxCompress::Dot_Compressed_Exact(
+	unsigned int* A,
+	long A_length,
+	unsigned int* B,
+	long B_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Dot_Compressed_Exact(A,A_length,B,B_length,num_threads);
+}
+
+double CvxCompress::Dot_Compressed_Exact(
+	unsigned int* A,
+	long A_length,
+	unsigned int* B,
+	long B_length,
+	int num_threads
+	)
+{
+	Check_Compressed_Operands("Dot_Compressed_Exact",A,B,true);
+	return Dot_Blocks(*this,A,B,num_threads);
+}
+
+double CvxCompress::Norm_Compressed(
+	unsigned int* A,
+	long A_length
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
+	}
+	return Norm_Compressed(A,A_length,num_threads);
+}
 
-		int x0 = iix*bx;
-		int y0 = iiy*by;
-		int z0 = iiz*bz;
-		
-		//printf("  iBlk=%d, x0=%d, y0=%d, z0=%d\n",iBlk,x0,y0,z0);
+double CvxCompress::Norm_Compressed(
+	unsigned int* A,
+	long A_length,
+	int num_threads
+	)
+{
+	Check_Compressed_Operands("Norm_Compressed",A,A,false);
+	double dot = Estimate_Dot_Blocks(A,A,num_threads,0L);
+	return sqrt(dot > 0.0 ? dot : 0.0);
+}
 
-		int thread_id = omp_get_thread_num();
-		float* priv_work = work + thread_id * work_size_one_thread;
-		float* priv_tmp = priv_work + bx*by*bz;
-		long priv_blkoff = glob_blkoffs[iBlk];
-		bool Is_Uncompressed = (priv_blkoff & 0x8000000000000000) ? true : false;
-		priv_blkoff = Is_Uncompressed ? (priv_blkoff & 0x7FFFFFFFFFFFFFFF) : priv_blkoff;
-		unsigned long* priv_compressed = (unsigned long*)(((char*)bytes) + priv_blkoff);
-		float mulfac = use_local_RMS ? blkmulfac[iBlk] : glob_mulfac;
-		//printf("  Is_Uncompressed=%s, priv_blkoff=%ld\n",Is_Uncompressed?"true":"false",priv_blkoff);
-		
-		if (Is_Uncompressed)
-		{
-			//printf("  iBlk=%ld is uncompressed!\n",iBlk);
-			memcpy(priv_work,priv_compressed,sizeof(float)*bx*by*bz);
-			Wavelet_Transform_Fast_Inverse((__m256*)priv_work,(__m256*)priv_tmp,bx,by,bz);
-			Copy_From_Block((__m128*)priv_work,bx,by,bz,vol,x0,y0,z0,nx,ny,nz);
-		}
-		else
-		{
-			Run_Length_Decode_Slow(mulfac,priv_work,bx*by*bz,priv_compressed);
-			//printf("...Run_Length_Decode_Slow done\n");  fflush(stdout);
-			Wavelet_Transform_Fast_Inverse((__m256*)priv_work,(__m256*)priv_tmp,bx,by,bz);
-			//printf("...Wavelet_Transform_Fast_Inverse done\n");  fflush(stdout);
-			Copy_From_Block((__m128*)priv_work,bx,by,bz,vol,x0,y0,z0,nx,ny,nz);
-			//printf("...Copy_From_Block done\n");  fflush(stdout);
-		}
+void CvxCompress::Block_Energy_Compressed(
+	unsigned int* A,
+	long A_length,
+	double* energy
+	)
+{
+	int num_threads;
+#pragma omp parallel
+	{
+		num_threads = omp_get_num_threads();
 	}
+	Block_Energy_Compressed(A,A_length,energy,num_threads);
+}
 
-	free(work);
+void CvxCompress::Block_Energy_Compressed(
+	unsigned int* A,
+	long A_length,
+	double* energy,
+	int num_threads
+	)
+{
+	Check_Compressed_Operands("Block_Energy_Compressed",A,A,false);
+	Estimate_Dot_Blocks(A,A,num_threads,energy);
 }
 
 //
@@ -732,6 +5676,55 @@ bool CvxCompress::Run_Module_Tests(bool verbose, bool exhaustive_throughput_test
 			}
 		}
 	}
+	// block sizes that are not powers of two
+	for (int bs = Min_BX()+Block_Size_Step();  bs <= 64;  bs += Block_Size_Step())
+	{
+		if ((1 << Find_Pow2(bs)) == bs) continue;
+		int shapes[2][3] = {{bs,bs,bs},{Min_BX(),bs,bs+Block_Size_Step()}};
+		for (int ishape = 0;  ishape < 2;  ++ishape)
+		{
+			int bx = shapes[ishape][0];
+			int by = shapes[ishape][1];
+			int bz = shapes[ishape][2];
+			if (verbose) printf("\x1B[0m -> %dx%dx%d ",bx,by,bz);  fflush(stdout);
+			Fill_Block(data1,data2,bx,by,bz);
+			Wavelet_Transform_Slow_Forward(data1,work,bx,by,bz,0,0,0,bx,by,bz);
+			Wavelet_Transform_Fast_Forward((__m256*)data2,(__m256*)work,bx,by,bz);
+			if (Compare_Blocks(data1,data2,bx,by,bz))
+			{
+				if (verbose) printf("\x1B[32mPassed!\n");
+			}
+			else
+			{
+				if (verbose) printf("\x1B[31mFailed!\n");
+				forward_passed = false;
+			}
+		}
+	}
+	// lifting engine
+	for (int bs = Min_BX();  bs <= 64;  bs += Block_Size_Step())
+	{
+		int shapes[3][3] = {{bs,bs,bs},{Min_BX(),bs,bs+Block_Size_Step()},{bs,bs+Block_Size_Step(),1}};
+		for (int ishape = 0;  ishape < 3;  ++ishape)
+		{
+			int bx = shapes[ishape][0];
+			int by = shapes[ishape][1];
+			int bz = shapes[ishape][2];
+			if (verbose) printf("\x1B[0m -> %dx%dx%d (lifting) ",bx,by,bz);  fflush(stdout);
+			Fill_Block(data1,data2,bx,by,bz);
+			Wavelet_Transform_Slow_Forward(data1,work,bx,by,bz,0,0,0,bx,by,bz);
+			Wavelet_Transform_Lifting_Forward((__m256*)data2,bx,by,bz);
+			if (Compare_Blocks(data1,data2,bx,by,bz))
+			{
+				if (verbose) printf("\x1B[32mPassed!\n");
+			}
+			else
+			{
+				if (verbose) printf("\x1B[31mFailed!\n");
+				forward_passed = false;
+			}
+		}
+	}
 	if (verbose)
 	{
 		printf("\x1B[0m\n");
@@ -772,6 +5765,55 @@ bool CvxCompress::Run_Module_Tests(bool verbose, bool exhaustive_throughput_test
 			}
 		}
 	}
+	// block sizes that are not powers of two
+	for (int bs = Min_BX()+Block_Size_Step();  bs <= 64;  bs += Block_Size_Step())
+	{
+		if ((1 << Find_Pow2(bs)) == bs) continue;
+		int shapes[2][3] = {{bs,bs,bs},{Min_BX(),bs,bs+Block_Size_Step()}};
+		for (int ishape = 0;  ishape < 2;  ++ishape)
+		{
+			int bx = shapes[ishape][0];
+			int by = shapes[ishape][1];
+			int bz = shapes[ishape][2];
+			if (verbose) printf("\x1B[0m -> %dx%dx%d ",bx,by,bz);  fflush(stdout);
+			Fill_Block(data1,data2,bx,by,bz);
+			Wavelet_Transform_Slow_Inverse(data1,work,bx,by,bz,0,0,0,bx,by,bz);
+			Wavelet_Transform_Fast_Inverse((__m256*)data2,(__m256*)work,bx,by,bz);
+			if (Compare_Blocks(data1,data2,bx,by,bz))
+			{
+				if (verbose) printf("\x1B[32mPassed!\n");
+			}
+			else
+			{
+				if (verbose) printf("\x1B[31mFailed!\n");
+				inverse_passed = false;
+			}
+		}
+	}
+	// lifting engine
+	for (int bs = Min_BX();  bs <= 64;  bs += Block_Size_Step())
+	{
+		int shapes[3][3] = {{bs,bs,bs},{Min_BX(),bs,bs+Block_Size_Step()},{bs,bs+Block_Size_Step(),1}};
+		for (int ishape = 0;  ishape < 3;  ++ishape)
+		{
+			int bx = shapes[ishape][0];
+			int by = shapes[ishape][1];
+			int bz = shapes[ishape][2];
+			if (verbose) printf("\x1B[0m -> %dx%dx%d (lifting) ",bx,by,bz);  fflush(stdout);
+			Fill_Block(data1,data2,bx,by,bz);
+			Wavelet_Transform_Slow_Inverse(data1,work,bx,by,bz,0,0,0,bx,by,bz);
+			Wavelet_Transform_Lifting_Inverse((__m256*)data2,bx,by,bz);
+			if (Compare_Blocks(data1,data2,bx,by,bz))
+			{
+				if (verbose) printf("\x1B[32mPassed!\n");
+			}
+			else
+			{
+				if (verbose) printf("\x1B[31mFailed!\n");
+				inverse_passed = false;
+			}
+		}
+	}
 	if (verbose)
 	{
 		printf("\x1B[0m\n");
@@ -885,6 +5927,23 @@ bool CvxCompress::Run_Module_Tests(bool verbose, bool exhaustive_throughput_test
 #else
 					printf(":: %6.3f secs - %.0f MCells/s - %.0f GF/s\n",elapsed.count(),mcells_per_second,GF_per_second);
 #endif
+
+					// same blocks with the lifting engine.
+					start = Time::now();
+#pragma omp parallel for schedule(static,1)
+					for (int iter = 0;  iter < niter;  ++iter)
+					{
+						int thread_id = omp_get_thread_num();
+						float* priv_data1 = data1 + (long)thread_id * buf_size;
+						float* priv_data2 = priv_data1 + bx * by * bz;
+						float* priv_work = priv_data2 + bx * by * bz;
+						Wavelet_Transform_Lifting_Forward((__m256*)priv_data2,bx,by,bz);
+						Wavelet_Transform_Lifting_Inverse((__m256*)priv_data2,bx,by,bz);
+					}
+					stop = Time::now();
+					elapsed = (stop - start);
+					mcells_per_second = (double)(bx*by*bz) * (double)niter / (elapsed.count() * 1e6);
+					printf("    %-24s:: %6.3f secs - %.0f MCells/s\n","lifting",elapsed.count(),mcells_per_second);
 				}
 			}
 		}
@@ -1235,6 +6294,940 @@ bool CvxCompress::Run_Module_Tests(bool verbose, bool exhaustive_throughput_test
 			}
 		}
 	}
+	printf("\n11. Verify reversible compression...");  fflush(stdout);
+	if (verbose) printf("\n");
+	bool reversible_passed = true;
+	{
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		// lossless streams of noisy data can be slightly larger than the input.
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		float rms3 = Compute_Global_RMS(vol3,nx3,ny3,nz3);
+		int bs_list[3] = {16, 24, 32};
+		for (int ibs = 0;  ibs < 3;  ++ibs)
+		{
+			int bs = bs_list[ibs];
+			for (int near_lossless = 0;  near_lossless < 2;  ++near_lossless)
+			{
+				float max_error = near_lossless ? 1e-3f * rms3 : 0.0f;
+				long compressed_length3 = 0l;
+				float ratio = Compress_Reversible(max_error,vol3,nx3,ny3,nz3,bs,bs,bs,compressed5,compressed_length3);
+				Decompress(vol5,nx3,ny3,nz3,compressed5,compressed_length3);
+				bool passed = true;
+				if (near_lossless)
+				{
+					for (long i = 0;  i < nn3 && passed;  ++i) passed = fabsf(vol5[i]-vol3[i]) <= max_error + fabsf(vol3[i]) * FLT_EPSILON;
+				}
+				else
+				{
+					passed = Check_Volume(vol3,vol5,nx3,ny3,nz3);
+				}
+				if (verbose) printf("\x1B[0m -> %2d x %2d x %2d %s ratio %.2f:1 %s\n",bs,bs,bs,near_lossless?"near-lossless":"lossless     ",ratio,passed?"\x1B[32mPassed!":"\x1B[31mFailed!");
+				reversible_passed = reversible_passed && passed;
+			}
+		}
+		free(vol5);
+		free(compressed5);
+	}
+	if (verbose)
+		printf("\x1B[0m\n");
+	else if (reversible_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n12. Verify double precision Compress() and Decompress()...");  fflush(stdout);
+	bool double_passed = true;
+	{
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		double* dvol = 0L;
+		posix_memalign((void**)&dvol, 64, sizeof(double)*nn3);
+		for (long i = 0;  i < nn3;  ++i) dvol[i] = (double)vol3[i];
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		// double input that is exactly representable as float must give the same blocks as float input.
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,false,(unsigned int*)compressed3,compressed_length3);
+		Compress(scale,dvol,nx3,ny3,nz3,32,32,32,false,compressed5,compressed_length5);
+		double_passed = (compressed_length3 == compressed_length5);
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		Decompress(dvol,nx3,ny3,nz3,compressed5,compressed_length5);
+		for (long i = 0;  i < nn3 && double_passed;  ++i) double_passed = (dvol[i] == (double)vol5[i]);
+		free(vol5);
+		free(compressed5);
+		free(dvol);
+	}
+	if (double_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n13. Verify half precision and bfloat16 Compress() and Decompress()...");  fflush(stdout);
+	bool half_passed = true;
+	{
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		cvx_float16* hvol = 0L;
+		posix_memalign((void**)&hvol, 64, sizeof(cvx_float16)*nn3);
+		cvx_bfloat16* bvol = 0L;
+		posix_memalign((void**)&bvol, 64, sizeof(cvx_bfloat16)*nn3);
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		// decoding straight to 16 bits must match rounding the float decode.
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,false,(unsigned int*)compressed3,compressed_length3);
+		Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		Decompress(hvol,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		Decompress(bvol,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		for (long i = 0;  i < nn3 && half_passed;  ++i) half_passed = (hvol[i].bits == Float_To_Half(vol5[i])) && (bvol[i].bits == Float_To_BFloat16(vol5[i]));
+		// 16 bit input must give the same stream as the equivalent float input.
+		for (int ibf = 0;  ibf < 2 && half_passed;  ++ibf)
+		{
+			for (long i = 0;  i < nn3;  ++i) vol5[i] = ibf ? BFloat16_To_Float(bvol[i].bits) : Half_To_Float(hvol[i].bits);
+			Compress(scale,vol5,nx3,ny3,nz3,32,32,32,false,(unsigned int*)compressed3,compressed_length3);
+			if (ibf)
+				Compress(scale,bvol,nx3,ny3,nz3,32,32,32,false,compressed5,compressed_length5);
+			else
+				Compress(scale,hvol,nx3,ny3,nz3,32,32,32,false,compressed5,compressed_length5);
+			half_passed = (compressed_length3 == compressed_length5);
+		}
+		free(compressed5);
+		free(vol5);
+		free(bvol);
+		free(hvol);
+	}
+	if (half_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n14. Verify Compress() and Decompress() of padded volumes...");  fflush(stdout);
+	bool padded_passed = true;
+	{
+		// 8 cell halo on all sides, odd padding in x so rows are not 32 byte aligned.
+		int halo = 8;
+		int ldx = nx3 + 2*halo + 1, ldy = ny3 + 2*halo, ldz = nz3 + 2*halo;
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		long nnpad = (long)ldx * (long)ldy * (long)ldz;
+		float* pvol = 0L;
+		posix_memalign((void**)&pvol, 64, sizeof(float)*nnpad);
+		for (long i = 0;  i < nnpad;  ++i) pvol[i] = -12345.0f;
+		for (int iz = 0;  iz < nz3;  ++iz)
+			for (int iy = 0;  iy < ny3;  ++iy)
+				memcpy(pvol+((long)(iz+halo)*ldy+iy+halo)*ldx+halo, vol3+((long)iz*ny3+iy)*nx3, sizeof(float)*nx3);
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		// local RMS makes the stream independent of the order in which the global RMS is summed.
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,true,(unsigned int*)compressed3,compressed_length3);
+		Compress(scale,pvol,nx3,ny3,nz3,ldx,ldy,halo,halo,halo,32,32,32,true,compressed5,compressed_length5);
+		padded_passed = (compressed_length3 == compressed_length5);
+		Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		for (long i = 0;  i < nnpad;  ++i) pvol[i] = -12345.0f;
+		Decompress(pvol,nx3,ny3,nz3,ldx,ldy,halo,halo,halo,compressed5,compressed_length5);
+		for (int iz = 0;  iz < ldz && padded_passed;  ++iz)
+		{
+			for (int iy = 0;  iy < ldy && padded_passed;  ++iy)
+			{
+				for (int ix = 0;  ix < ldx && padded_passed;  ++ix)
+				{
+					bool interior = ix >= halo && ix < halo+nx3 && iy >= halo && iy < halo+ny3 && iz >= halo && iz < halo+nz3;
+					float expected = interior ? vol5[((long)(iz-halo)*ny3+(iy-halo))*nx3+(ix-halo)] : -12345.0f;
+					padded_passed = (pvol[((long)iz*ldy+iy)*ldx+ix] == expected);
+				}
+			}
+		}
+		free(vol5);
+		free(compressed5);
+		free(pvol);
+	}
+	if (padded_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n15. Verify Compress_Z_Fast() and Decompress_Z_Fast()...");  fflush(stdout);
+	bool z_fast_passed = true;
+	{
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* tvol = 0L;
+		posix_memalign((void**)&tvol, 64, sizeof(float)*nn3);
+#pragma omp parallel for
+		for (int ix = 0;  ix < nx3;  ++ix)
+			for (int iy = 0;  iy < ny3;  ++iy)
+				for (int iz = 0;  iz < nz3;  ++iz)
+					tvol[((long)ix*ny3+iy)*nz3+iz] = vol3[((long)iz*ny3+iy)*nx3+ix];
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		// anisotropic block, the transposed stream must decode to the same samples.
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,16,32,64,true,(unsigned int*)compressed3,compressed_length3);
+		Compress_Z_Fast(scale,tvol,nx3,ny3,nz3,16,32,64,true,compressed5,compressed_length5);
+		z_fast_passed = (compressed_length3 == compressed_length5);
+		Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		Decompress_Z_Fast(tvol,nx3,ny3,nz3,compressed5,compressed_length5);
+		for (int ix = 0;  ix < nx3 && z_fast_passed;  ++ix)
+			for (int iy = 0;  iy < ny3 && z_fast_passed;  ++iy)
+				for (int iz = 0;  iz < nz3 && z_fast_passed;  ++iz)
+					z_fast_passed = (tvol[((long)ix*ny3+iy)*nz3+iz] == vol5[((long)iz*ny3+iy)*nx3+ix]);
+		free(vol5);
+		free(compressed5);
+		free(tvol);
+	}
+	if (z_fast_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n16. Verify Compress_Gathers() and Decompress_Gathers()...");  fflush(stdout);
+	bool gathers_passed = true;
+	{
+		// every z slice of the test volume is a gather.
+		long nxy3 = (long)nx3 * (long)ny3;
+		const float** gathers = new const float*[nz3];
+		float** gathers2 = new float*[nz3];
+		unsigned int** gather_streams = new unsigned int*[nz3];
+		long* gather_lengths = new long[nz3];
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nxy3*nz3);
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nxy3*nz3);
+		for (int iz = 0;  iz < nz3;  ++iz)
+		{
+			gathers[iz] = vol3 + iz*nxy3;
+			gathers2[iz] = vol5 + iz*nxy3;
+			gather_streams[iz] = compressed5 + 2*iz*nxy3;
+		}
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && gathers_passed;  ++use_local_RMS)
+		{
+			Compress_Gathers(scale,gathers,nz3,nx3,ny3,16,32,use_local_RMS,gather_streams,gather_lengths);
+			Decompress_Gathers(gathers2,nz3,nx3,ny3,gather_streams,gather_lengths);
+			// streams decode with regular Decompress too.
+			float* slice = (float*)compressed3;
+			for (int iz = 0;  iz < nz3 && gathers_passed;  ++iz)
+			{
+				Decompress(slice,nx3,ny3,1,gather_streams[iz],gather_lengths[iz]);
+				gathers_passed = Check_Volume(slice,gathers2[iz],nx3,ny3,1);
+			}
+		}
+		free(compressed5);
+		free(vol5);
+		delete [] gather_lengths;
+		delete [] gather_streams;
+		delete [] gathers2;
+		delete [] gathers;
+	}
+	if (gathers_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n17. Verify Compress_Batch() and Decompress_Batch()...");  fflush(stdout);
+	bool batch_passed = true;
+	{
+		// every stream in the batch must decode to the same samples as the one Compress() produces for the same volume.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 4*sizeof(float)*nn3);
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		for (long i = 0;  i < nn3;  ++i) vol5[i] = 2.0f * vol3[i] * vol3[i];
+		const float* vols[2] = {vol3, vol5};
+		float* decoded[2] = {vol5+nn3, vol5+2*nn3};
+		float* vol6 = vol5+3*nn3;
+		unsigned int* streams[2] = {compressed5, compressed5+nn3};
+		long lengths[2] = {0l, 0l};
+		Compress_Batch(scale,vols,2,nx3,ny3,nz3,32,32,32,true,streams,lengths);
+		Decompress_Batch(decoded,2,nx3,ny3,nz3,streams,lengths);
+		for (int ivol = 0;  ivol < 2 && batch_passed;  ++ivol)
+		{
+			long compressed_length3 = 0l;
+			Compress(scale,(float*)vols[ivol],nx3,ny3,nz3,32,32,32,true,(unsigned int*)compressed3,compressed_length3);
+			batch_passed = (compressed_length3 == lengths[ivol]);
+			if (batch_passed)
+			{
+				Decompress(vol6,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+				batch_passed = Check_Volume(vol6,decoded[ivol],nx3,ny3,nz3);
+			}
+		}
+		free(compressed5);
+		free(vol5);
+	}
+	if (batch_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n18. Verify Compress_Delta() and Decompress_Delta()...");  fflush(stdout);
+	bool delta_passed = true;
+	{
+		// three slowly growing snapshots: key frame, residual against previous, residual against extrapolation.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 7*sizeof(float)*nn3);
+		float* snap = vol5;
+		float* enc[3] = {vol5+nn3, vol5+2*nn3, vol5+3*nn3};
+		float* dec[3] = {vol5+4*nn3, vol5+5*nn3, vol5+6*nn3};
+		long key_length = 0l;
+		for (int t = 0;  t < 3 && delta_passed;  ++t)
+		{
+			for (long i = 0;  i < nn3;  ++i) snap[i] = (1.0f + 0.01f * t) * vol3[i];
+			const float* prev = t >= 1 ? enc[t-1] : 0L;
+			const float* prev2 = t >= 2 ? enc[t-2] : 0L;
+			long compressed_length3 = 0l;
+			Compress_Delta(scale,snap,prev,prev2,nx3,ny3,nz3,32,32,32,(unsigned int*)compressed3,enc[t],compressed_length3);
+			Decompress_Delta(dec[t],t >= 1 ? dec[t-1] : 0L,t >= 2 ? dec[t-2] : 0L,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			// decoder must track the encoder exactly, or errors accumulate over the sequence.
+			delta_passed = memcmp(enc[t],dec[t],sizeof(float)*nn3) == 0;
+			if (t == 0)
+				key_length = compressed_length3;
+			else
+				delta_passed = delta_passed && compressed_length3 < key_length;
+		}
+		free(vol5);
+	}
+	if (delta_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n19. Verify Compress_4D() and Decompress_4D()...");  fflush(stdout);
+	bool four_d_passed = true;
+	{
+		// slowly growing snapshots, the last time block is partial.
+		int nt = 10;
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3*nt);
+		float* vol6 = vol5 + nn3*nt;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3*nt);
+		for (int it = 0;  it < nt;  ++it)
+			for (long i = 0;  i < nn3;  ++i)
+				vol5[it*nn3+i] = (1.0f + 0.01f * it) * vol3[i];
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		double err3 = 0.0, err5 = 0.0, sum = 0.0;
+		for (int it = 0;  it < nt;  ++it)
+		{
+			long len = 0l;
+			Compress(scale,vol5+it*nn3,nx3,ny3,nz3,32,32,32,false,(unsigned int*)compressed3,len);
+			Decompress(vol6+it*nn3,nx3,ny3,nz3,(unsigned int*)compressed3,len);
+			compressed_length3 += len;
+		}
+		for (long i = 0;  i < nn3*nt;  ++i) {double diff = vol6[i] - vol5[i];  err3 += diff*diff;  sum += (double)vol5[i]*vol5[i];}
+		Compress_4D(scale,vol5,nx3,ny3,nz3,nt,32,32,32,8,false,compressed5,compressed_length5);
+		Decompress_4D(vol6,nx3,ny3,nz3,nt,compressed5,compressed_length5);
+		for (long i = 0;  i < nn3*nt;  ++i) {double diff = vol6[i] - vol5[i];  err5 += diff*diff;}
+		// same threshold, so error must be comparable while the stream is smaller.
+		four_d_passed = compressed_length5 < compressed_length3 && sqrt(err5/sum) < 1.5*sqrt(err3/sum) + 1e-6;
+		free(compressed5);
+		free(vol5);
+	}
+	if (four_d_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n20. Verify complex Compress() and Decompress()...");  fflush(stdout);
+	bool complex_passed = true;
+	{
+		// real part is the test volume, imaginary part a scaled and shifted copy of it.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		std::complex<float>* cvol = 0L;
+		posix_memalign((void**)&cvol, 64, 2*sizeof(std::complex<float>)*nn3);
+		std::complex<float>* cvol2 = cvol + nn3;
+		for (long i = 0;  i < nn3;  ++i) cvol[i] = std::complex<float>(vol3[i], 0.5f*vol3[(i+nx3)%nn3]);
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && complex_passed;  ++use_local_RMS)
+		{
+			long compressed_length3 = 0l;
+			Compress(scale,cvol,nx3,ny3,nz3,32,32,32,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+			Decompress(cvol2,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			double err = 0.0, err_re = 0.0, sum = 0.0, sum_re = 0.0;
+			for (long i = 0;  i < nn3;  ++i) {err += std::norm(cvol2[i]-cvol[i]);  sum += std::norm(cvol[i]);}
+			// error should be on par with compressing the real part on its own.
+			Compress(scale,vol3,nx3,ny3,nz3,32,32,32,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+			Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			for (long i = 0;  i < nn3;  ++i) {double diff = vol5[i] - vol3[i];  err_re += diff*diff;  sum_re += (double)vol3[i]*vol3[i];}
+			complex_passed = sqrt(err/sum) < 2.0*sqrt(err_re/sum_re) + 1e-6;
+		}
+		free(vol5);
+		free(cvol);
+	}
+	if (complex_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n21. Verify Compress_Components() and Decompress_Components()...");  fflush(stdout);
+	bool components_passed = true;
+	{
+		// three components that are many orders of magnitude apart.
+		const int nc = 3;
+		const float cscale[nc] = {1.0f, 1e-4f, 1e3f};
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* cvol = 0L;
+		posix_memalign((void**)&cvol, 64, 2*sizeof(float)*nc*nn3);
+		float* cvol2 = cvol + nc*nn3;
+		for (long i = 0;  i < nn3;  ++i)
+			for (int ic = 0;  ic < nc;  ++ic)
+				cvol[i*nc+ic] = cscale[ic] * vol3[(i+ic*nx3)%nn3];
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nc*nn3);
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && components_passed;  ++use_local_RMS)
+		{
+			long compressed_length3 = 0l, compressed_length5 = 0l;
+			Compress_Components(scale,cvol,nc,nx3,ny3,nz3,32,32,32,use_local_RMS,compressed5,compressed_length5);
+			Decompress_Components(cvol2,nc,nx3,ny3,nz3,compressed5,compressed_length5);
+			Compress(scale,vol3,nx3,ny3,nz3,32,32,32,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+			Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			double err_ref = 0.0, sum_ref = 0.0;
+			for (long i = 0;  i < nn3;  ++i) {double diff = vol5[i] - vol3[i];  err_ref += diff*diff;  sum_ref += (double)vol3[i]*vol3[i];}
+			// every component should be on par with compressing it on its own, no matter how small it is.
+			for (int ic = 0;  ic < nc;  ++ic)
+			{
+				double err = 0.0, sum = 0.0;
+				for (long i = 0;  i < nn3;  ++i) {double diff = cvol2[i*nc+ic] - cvol[i*nc+ic];  err += diff*diff;  sum += (double)cvol[i*nc+ic]*cvol[i*nc+ic];}
+				if (!(sqrt(err/sum) < 2.0*sqrt(err_ref/sum_ref) + 1e-6)) components_passed = false;
+			}
+		}
+		free(vol5);
+		free(compressed5);
+		free(cvol);
+	}
+	if (components_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n22. Verify Compress() with a given global RMS...");  fflush(stdout);
+	bool given_rms_passed = true;
+	{
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		// 0 computes the RMS and returns it, passing it back in must produce the same stream.
+		float rms = 0.0f;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,false,rms,(unsigned int*)compressed3,compressed_length3);
+		given_rms_passed = fabs(rms - Compute_Global_RMS(vol3,nx3,ny3,nz3)) <= 1e-6f * rms;
+		float given = rms;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,false,given,compressed5,compressed_length5);
+		// the last 7 bytes of a stream are slack and never written.
+		given_rms_passed = given_rms_passed && given == rms && compressed_length3 == compressed_length5 && memcmp(compressed3,compressed5,compressed_length3-7) == 0;
+		// a supplied RMS goes straight into the quantization factor.
+		given = 2.0f*rms;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,false,given,compressed5,compressed_length5);
+		float mulfac;
+		memcpy(&mulfac, compressed5+6, sizeof(float));
+		given_rms_passed = given_rms_passed && given == 2.0f*rms && fabs(mulfac*2.0f*rms*scale - 1.0f) < 1e-5f;
+		// local RMS leaves it alone.
+		given = 0.0f;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,true,given,compressed5,compressed_length5);
+		given_rms_passed = given_rms_passed && given == 0.0f;
+		// Transcode returns its estimate of the RMS.
+		Transcode(scale,(unsigned int*)compressed3,compressed_length3,given,compressed5,compressed_length5);
+		given_rms_passed = given_rms_passed && fabs(given - rms) <= 0.01f * rms;
+		free(compressed5);
+	}
+	if (given_rms_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n23. Verify Axpy_Compressed()...");  fflush(stdout);
+	bool axpy_passed = true;
+	{
+		// C = 2*A - B where B is a shifted and scaled copy of the test volume.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 3*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		float* vol7 = vol6 + nn3;
+		for (long i = 0;  i < nn3;  ++i) vol5[i] = 0.5f * vol3[(i+nx3)%nn3];
+		for (long i = 0;  i < nn3;  ++i) vol6[i] = 2.0f * vol3[i] - vol5[i];
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 3*sizeof(float)*nn3);
+		unsigned int* compressed6 = compressed5 + nn3;
+		unsigned int* compressed7 = compressed6 + nn3;
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && axpy_passed;  ++use_local_RMS)
+		{
+			long compressed_length3 = 0l, compressed_length5 = 0l, compressed_length7 = 0l;
+			Compress(scale,vol3,nx3,ny3,nz3,32,32,32,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+			Compress(scale,vol5,nx3,ny3,nz3,32,32,32,use_local_RMS,compressed5,compressed_length5);
+			Axpy_Compressed(2.0f,(unsigned int*)compressed3,compressed_length3,-1.0f,compressed5,compressed_length5,scale,use_local_RMS,compressed7,compressed_length7);
+			Decompress(vol7,nx3,ny3,nz3,compressed7,compressed_length7);
+			double err = 0.0, sum = 0.0;
+			for (long i = 0;  i < nn3;  ++i) {double diff = vol7[i] - vol6[i];  err += diff*diff;  sum += (double)vol6[i]*vol6[i];}
+			// inputs and output are each quantized once, so the error can be a few times that of compressing C directly.
+			Compress(scale,vol6,nx3,ny3,nz3,32,32,32,use_local_RMS,compressed7,compressed_length7);
+			Decompress(vol7,nx3,ny3,nz3,compressed7,compressed_length7);
+			double err_ref = 0.0;
+			for (long i = 0;  i < nn3;  ++i) {double diff = vol7[i] - vol6[i];  err_ref += diff*diff;}
+			axpy_passed = sqrt(err/sum) < 3.0*sqrt(err_ref/sum) + 1e-6;
+		}
+		free(compressed5);
+		free(vol5);
+	}
+	if (axpy_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n24. Verify Dot_Compressed(), Norm_Compressed() and Block_Energy_Compressed()...");  fflush(stdout);
+	bool dot_passed = true;
+	{
+		// must agree with the same reductions over the decompressed volumes, the estimates from the coefficients to within a few percent.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 3*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		float* vol7 = vol6 + nn3;
+		for (long i = 0;  i < nn3;  ++i) vol5[i] = 0.5f * vol3[(i+nx3)%nn3];
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,false,(unsigned int*)compressed3,compressed_length3);
+		Compress(scale,vol5,nx3,ny3,nz3,32,32,32,true,compressed5,compressed_length5);
+		Decompress(vol6,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		Decompress(vol7,nx3,ny3,nz3,compressed5,compressed_length5);
+		double dot = 0.0, norm2 = 0.0;
+		for (long i = 0;  i < nn3;  ++i) {dot += (double)vol6[i]*vol7[i];  norm2 += (double)vol6[i]*vol6[i];}
+		double norm5 = sqrt(Dot_Compressed_Exact(compressed5,compressed_length5,compressed5,compressed_length5));
+		double xdot = Dot_Compressed_Exact((unsigned int*)compressed3,compressed_length3,compressed5,compressed_length5);
+		dot_passed = fabs(xdot - dot) <= 1e-9 * sqrt(norm2) * norm5 + 1e-9;
+		double cdot = Dot_Compressed((unsigned int*)compressed3,compressed_length3,compressed5,compressed_length5);
+		double cnorm = Norm_Compressed((unsigned int*)compressed3,compressed_length3);
+		dot_passed = dot_passed && fabs(cdot - dot) <= 0.02 * sqrt(norm2) * norm5 && fabs(cnorm - sqrt(norm2)) <= 0.01 * sqrt(norm2);
+		// first block sits in the corner of the volume.
+		int nbx = (nx3+31)/32, nby = (ny3+31)/32, nbz = (nz3+31)/32;
+		double* energy = new double[nbx*nby*nbz];
+		Block_Energy_Compressed((unsigned int*)compressed3,compressed_length3,energy);
+		double energy_sum = 0.0, energy0 = 0.0;
+		for (int i = 0;  i < nbx*nby*nbz;  ++i) energy_sum += energy[i];
+		for (int iz = 0;  iz < 32;  ++iz)
+			for (int iy = 0;  iy < 32;  ++iy)
+				for (int ix = 0;  ix < 32;  ++ix)
+				{
+					double val = vol6[((long)iz*ny3+iy)*nx3+ix];
+					energy0 += val*val;
+				}
+		dot_passed = dot_passed && fabs(energy_sum - norm2) <= 0.02 * norm2 && fabs(energy[0] - energy0) <= 0.1 * energy0 + 1e-6 * norm2;
+		delete [] energy;
+		free(compressed5);
+		free(vol5);
+	}
+	if (dot_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n25. Verify Decompress_Accumulate() and Decompress_Multiply_Accumulate()...");  fflush(stdout);
+	bool accumulate_passed = true;
+	{
+		// must match Decompress followed by the same update done by hand.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 3*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		float* vol7 = vol6 + nn3;
+		for (long i = 0;  i < nn3;  ++i) vol5[i] = 0.5f * vol3[(i+nx3)%nn3];
+		long compressed_length3 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,true,(unsigned int*)compressed3,compressed_length3);
+		Decompress(vol6,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		memcpy(vol7,vol5,sizeof(float)*nn3);
+		Decompress_Accumulate(vol7,-0.5f,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		for (long i = 0;  i < nn3 && accumulate_passed;  ++i)
+		{
+			float expected = vol5[i] - 0.5f * vol6[i];
+			accumulate_passed = fabsf(vol7[i] - expected) <= 1e-6f * (fabsf(vol5[i]) + fabsf(vol6[i])) + 1e-30f;
+		}
+		memcpy(vol7,vol5,sizeof(float)*nn3);
+		Decompress_Multiply_Accumulate(vol7,vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		for (long i = 0;  i < nn3 && accumulate_passed;  ++i)
+		{
+			float expected = vol5[i] + vol5[i] * vol6[i];
+			accumulate_passed = fabsf(vol7[i] - expected) <= 1e-6f * (fabsf(vol5[i]) + fabsf(vol5[i] * vol6[i])) + 1e-30f;
+		}
+		free(vol5);
+	}
+	if (accumulate_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n26. Verify Compress_Tiers()...");  fflush(stdout);
+	bool tiers_passed = true;
+	{
+		// every tier must decompress to the same volume as a separate Compress with its scale.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		unsigned int* tier_streams[2] = {compressed5, compressed5 + nn3};
+		float tier_scales[2] = {scale, 10.0f*scale};
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && tiers_passed;  ++use_local_RMS)
+		{
+			long tier_lengths[2];
+			Compress_Tiers(tier_scales,2,vol3,nx3,ny3,nz3,32,32,32,use_local_RMS,tier_streams,tier_lengths);
+			tiers_passed = tier_lengths[1] < tier_lengths[0];
+			for (int itier = 0;  itier < 2 && tiers_passed;  ++itier)
+			{
+				long compressed_length3 = 0l;
+				Compress(tier_scales[itier],vol3,nx3,ny3,nz3,32,32,32,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+				Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+				Decompress(vol6,nx3,ny3,nz3,tier_streams[itier],tier_lengths[itier]);
+				tiers_passed = tier_lengths[itier] == compressed_length3 && memcmp(vol5,vol6,sizeof(float)*nn3) == 0;
+			}
+		}
+		free(compressed5);
+		free(vol5);
+	}
+	if (tiers_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n27. Verify Transcode()...");  fflush(stdout);
+	bool transcode_passed = true;
+	{
+		// a coarser stream from the compressed volume must be about as good as compressing the volume with the coarser scale.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, sizeof(float)*nn3);
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && transcode_passed;  ++use_local_RMS)
+		{
+			long compressed_length3 = 0l, compressed_length5 = 0l;
+			Compress(scale,vol3,nx3,ny3,nz3,32,32,32,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+			Transcode(10.0f*scale,(unsigned int*)compressed3,compressed_length3,compressed5,compressed_length5);
+			Decompress(vol5,nx3,ny3,nz3,compressed5,compressed_length5);
+			double err = 0.0, sum = 0.0;
+			for (long i = 0;  i < nn3;  ++i) {double diff = vol5[i] - vol3[i];  err += diff*diff;  sum += (double)vol3[i]*vol3[i];}
+			long transcoded_length = compressed_length5;
+			Compress(10.0f*scale,vol3,nx3,ny3,nz3,32,32,32,use_local_RMS,compressed5,compressed_length5);
+			Decompress(vol5,nx3,ny3,nz3,compressed5,compressed_length5);
+			double err_ref = 0.0;
+			for (long i = 0;  i < nn3;  ++i) {double diff = vol5[i] - vol3[i];  err_ref += diff*diff;}
+			transcode_passed = transcoded_length < compressed_length3 && sqrt(err/sum) < 1.5*sqrt(err_ref/sum) + 1e-6;
+		}
+		free(compressed5);
+		free(vol5);
+	}
+	if (transcode_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n28. Verify Stitch_Compressed()...");  fflush(stdout);
+	bool stitch_passed = true;
+	{
+		// split the test volume in 2x2 pieces along x and y, must decompress to the decompressed pieces put side by side.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		int px0[4], py0[4], pz0[4], pnx[4], pny[4];
+		unsigned int* pieces[4];
+		long piece_length[4];
+		for (int common_rms = 0;  common_rms < 2 && stitch_passed;  ++common_rms)
+		{
+			unsigned int* next_piece = compressed5;
+			for (int ip = 0;  ip < 4;  ++ip)
+			{
+				px0[ip] = (ip & 1) ? 64 : 0;
+				py0[ip] = (ip & 2) ? 32 : 0;
+				pz0[ip] = 0;
+				pnx[ip] = (ip & 1) ? nx3 - 64 : 64;
+				pny[ip] = (ip & 2) ? ny3 - 32 : 32;
+				float* piece = vol6;
+				for (int iz = 0;  iz < nz3;  ++iz)
+					for (int iy = 0;  iy < pny[ip];  ++iy)
+						for (int ix = 0;  ix < pnx[ip];  ++ix)
+							piece[((long)iz*pny[ip]+iy)*pnx[ip]+ix] = vol3[((long)iz*ny3+py0[ip]+iy)*nx3+px0[ip]+ix];
+				float piece_rms = common_rms ? 1.0f : 0.0f;
+				pieces[ip] = next_piece;
+				Compress(scale,piece,pnx[ip],pny[ip],nz3,32,32,32,false,piece_rms,pieces[ip],piece_length[ip]);
+				next_piece += (piece_length[ip] + 63) / 64 * 16;
+				Decompress(piece,pnx[ip],pny[ip],nz3,pieces[ip],piece_length[ip]);
+				for (int iz = 0;  iz < nz3;  ++iz)
+					for (int iy = 0;  iy < pny[ip];  ++iy)
+						for (int ix = 0;  ix < pnx[ip];  ++ix)
+							vol5[((long)iz*ny3+py0[ip]+iy)*nx3+px0[ip]+ix] = piece[((long)iz*pny[ip]+iy)*pnx[ip]+ix];
+			}
+			long compressed_length3 = 0l;
+			Stitch_Compressed(pieces,piece_length,px0,py0,pz0,4,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			Decompress(vol6,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			// pieces with a common RMS share one global factor, so the stitched stream needs no per block factors.
+			bool global = (((unsigned int*)compressed3)[7] & 1) == 0;
+			stitch_passed = memcmp(vol5,vol6,sizeof(float)*nn3) == 0 && global == (common_rms == 1);
+		}
+		free(compressed5);
+		free(vol5);
+	}
+	if (stitch_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n29. Verify Compress_Shards() and Decompress_Shards()...");  fflush(stdout);
+	bool shards_passed = true;
+	{
+		// shards decompressed one at a time must give the volume, and stitched together the same volume as one Compress.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		const int nshard = 3;
+		unsigned int* shards[nshard];
+		long shard_length[nshard];
+		long manifest[4+3*nshard];
+		for (int ishard = 0;  ishard < nshard;  ++ishard) shards[ishard] = compressed5 + ishard*(nn3*2/nshard);
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && shards_passed;  ++use_local_RMS)
+		{
+			Compress_Shards(scale,vol3,nx3,ny3,nz3,32,32,8,use_local_RMS,nshard,shards,shard_length,manifest);
+			for (long i = 0;  i < nn3;  ++i) vol6[i] = -1.0f;
+			for (int ishard = nshard-1;  ishard >= 0;  --ishard) Decompress_Shard(vol6,nx3,ny3,nz3,manifest,ishard,shards[ishard],shard_length[ishard]);
+			long compressed_length3 = 0l;
+			Compress(scale,vol3,nx3,ny3,nz3,32,32,8,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+			Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			shards_passed = manifest[3] == nshard && manifest[4] == 0 && manifest[4+3*(nshard-1)] + manifest[5+3*(nshard-1)] == nz3 && memcmp(vol5,vol6,sizeof(float)*nn3) == 0;
+			int zeros[nshard] = {0}, sz0[nshard];
+			for (int ishard = 0;  ishard < nshard;  ++ishard) sz0[ishard] = (int)manifest[4+3*ishard];
+			Stitch_Compressed(shards,shard_length,zeros,zeros,sz0,nshard,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			Decompress(vol6,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			shards_passed = shards_passed && memcmp(vol5,vol6,sizeof(float)*nn3) == 0;
+		}
+		free(compressed5);
+		free(vol5);
+	}
+	if (shards_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n30. Verify compact block index...");  fflush(stdout);
+	bool compact_passed = true;
+	{
+		// expand the compact index of a stream into the 8 byte index, both must decompress to the same volume.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, sizeof(float)*nn3);
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && compact_passed;  ++use_local_RMS)
+		{
+			unsigned int* compact = (unsigned int*)compressed3;
+			long compressed_length3 = 0l;
+			Compress(scale,vol3,nx3,ny3,nz3,8,8,8,use_local_RMS,compact,compressed_length3);
+			int nt, bt, nc, nm;
+			int hdr_words = Stream_Header_Words(compact,nt,bt,nc,nm);
+			long nnn = Stream_Num_Blocks(compact);
+			long compact_bytes = Block_Index_Bytes(nnn,true);
+			compact_passed = (compact[7] & 128) && compact_bytes < Block_Index_Bytes(nnn,false);
+			memcpy(compressed5,compact,sizeof(int)*hdr_words);
+			compressed5[7] &= ~128;
+			long* wide = (long*)(compressed5+hdr_words);
+			for (long iBlk = 0;  iBlk < nnn;  ++iBlk) wide[iBlk] = Get_Block_Offset(compact+hdr_words,nnn,true,iBlk);
+			long tail = compressed_length3 - 4*hdr_words - compact_bytes;
+			memcpy(wide+nnn,((char*)(compact+hdr_words))+compact_bytes,tail);
+			long compressed_length5 = 4*hdr_words + 8*nnn + tail;
+			Decompress(vol5,nx3,ny3,nz3,compact,compressed_length3);
+			Decompress(vol6,nx3,ny3,nz3,compressed5,compressed_length5);
+			compact_passed = compact_passed && memcmp(vol5,vol6,sizeof(float)*nn3) == 0;
+		}
+		free(compressed5);
+		free(vol5);
+	}
+	if (compact_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n31. Verify Compress_Fixed_Size() and Decompress_Block()...");  fflush(stdout);
+	bool fixed_passed = true;
+	{
+		// slots with room for every block must decode like Compress, small slots must keep their size and decode block by block like the whole volume.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		float* blk = 0L;
+		posix_memalign((void**)&blk, 64, sizeof(float)*16*16*16);
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		long nbx = (nx3+15)/16, nby = (ny3+15)/16, nbz = (nz3+15)/16;
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,16,16,16,false,(unsigned int*)compressed3,compressed_length3);
+		Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		double err_ref = 0.0, err_fixed = 0.0;
+		Compress_Fixed_Size(scale,vol3,nx3,ny3,nz3,16,16,16,false,4+5*16*16*16,compressed5,compressed_length5);
+		Decompress(vol6,nx3,ny3,nz3,compressed5,compressed_length5);
+		for (long i = 0;  i < nn3;  ++i)
+		{
+			err_ref += ((double)vol5[i] - (double)vol3[i]) * ((double)vol5[i] - (double)vol3[i]);
+			err_fixed += ((double)vol6[i] - (double)vol3[i]) * ((double)vol6[i] - (double)vol3[i]);
+		}
+		fixed_passed = err_fixed <= 1.01 * err_ref + 1e-12 * (double)nn3;
+		for (int block_bytes = 1024;  block_bytes >= 64 && fixed_passed;  block_bytes /= 4)
+		{
+			Compress_Fixed_Size(scale,vol3,nx3,ny3,nz3,16,16,16,true,block_bytes,compressed5,compressed_length5);
+			fixed_passed = compressed_length5 == 40 + nbx*nby*nbz*block_bytes + 7;
+			Decompress(vol6,nx3,ny3,nz3,compressed5,compressed_length5);
+			for (int iz = 0;  iz < nbz && fixed_passed;  iz += 3)
+			{
+				int ix = iz % nbx, iy = (2*iz) % nby;
+				Decompress_Block(blk,ix,iy,iz,compressed5);
+				for (int z = 0;  z < 16 && iz*16+z < nz3;  ++z)
+					for (int y = 0;  y < 16 && iy*16+y < ny3;  ++y)
+						for (int x = 0;  x < 16 && ix*16+x < nx3;  ++x)
+							fixed_passed = fixed_passed && blk[(z*16+y)*16+x] == vol6[((long)(iz*16+z)*ny3+iy*16+y)*nx3+ix*16+x];
+			}
+		}
+		// 2D fixed size streams decode with Decompress_Gathers too.
+		long nxy3 = (long)nx3 * (long)ny3;
+		float* gathers[2] = {vol5, vol5 + nxy3};
+		unsigned int* gather_streams[2] = {compressed5, compressed5 + nn3};
+		long gather_lengths[2];
+		for (int iz = 0;  iz < 2;  ++iz)
+		{
+			Compress_Fixed_Size(scale,vol3+iz*nxy3,nx3,ny3,1,32,32,1,iz == 1,512,gather_streams[iz],gather_lengths[iz]);
+			Decompress(vol6+iz*nxy3,nx3,ny3,1,gather_streams[iz],gather_lengths[iz]);
+		}
+		Decompress_Gathers(gathers,2,nx3,ny3,gather_streams,gather_lengths);
+		fixed_passed = fixed_passed && memcmp(vol5,vol6,2*sizeof(float)*nxy3) == 0;
+		free(compressed5);
+		free(blk);
+		free(vol5);
+	}
+	if (fixed_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n32. Verify Compress_Adaptive()...");  fflush(stdout);
+	bool adaptive_passed = true;
+	{
+		// blocks that are never split must decode like Compress, split blocks must decode block by block like the whole volume.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		// the caller's work area is reused for every block.
+		float* blk = 0L;
+		posix_memalign((void**)&blk, 64, sizeof(float)*(2*32*32*32+8*32));
+		float* blk_work = blk + 32*32*32;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		long compressed_length3 = 0l, compressed_length5 = 0l;
+		Compress(scale,vol3,nx3,ny3,nz3,32,32,32,false,(unsigned int*)compressed3,compressed_length3);
+		Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+		Compress_Adaptive(scale,vol3,nx3,ny3,nz3,32,32,32,2,1e30f,false,compressed5,compressed_length5);
+		Decompress(vol6,nx3,ny3,nz3,compressed5,compressed_length5);
+		adaptive_passed = memcmp(vol5,vol6,sizeof(float)*nn3) == 0;
+		int nbx = (nx3+31)/32, nby = (ny3+31)/32, nbz = (nz3+31)/32;
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && adaptive_passed;  ++use_local_RMS)
+		{
+			Compress_Adaptive(scale,vol3,nx3,ny3,nz3,32,32,32,2,0.5f,use_local_RMS,compressed5,compressed_length5);
+			Decompress(vol6,nx3,ny3,nz3,compressed5,compressed_length5);
+			for (int iz = 0;  iz < nbz && adaptive_passed;  ++iz)
+			{
+				int ix = iz % nbx, iy = (2*iz) % nby;
+				Decompress_Block(blk,ix,iy,iz,compressed5,blk_work);
+				for (int z = 0;  z < 32 && iz*32+z < nz3;  ++z)
+					for (int y = 0;  y < 32 && iy*32+y < ny3;  ++y)
+						for (int x = 0;  x < 32 && ix*32+x < nx3;  ++x)
+							adaptive_passed = adaptive_passed && blk[(z*32+y)*32+x] == vol6[((long)(iz*32+z)*ny3+iy*32+y)*nx3+ix*32+x];
+			}
+		}
+		free(compressed5);
+		free(blk);
+		free(vol5);
+	}
+	if (adaptive_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
+	printf("\n33. Verify Compress_Masked()...");  fflush(stdout);
+	bool masked_passed = true;
+	{
+		// blocks of excluded cells must decode to the fill value and the others like Compress, a mask and the same boxes must give the same stream.
+		long nn3 = (long)nx3 * (long)ny3 * (long)nz3;
+		float* vol5 = 0L;
+		posix_memalign((void**)&vol5, 64, 2*sizeof(float)*nn3);
+		float* vol6 = vol5 + nn3;
+		unsigned int* compressed5 = 0L;
+		posix_memalign((void**)&compressed5, 64, 2*sizeof(float)*nn3);
+		unsigned int* compressed6 = compressed5 + nn3;
+		unsigned char* mask = new unsigned char[nn3];
+		const int pml = 20;
+		int boxes[12] = {0,0,0,pml,ny3,nz3, 0,0,0,nx3,ny3,2*pml};
+		for (long iz = 0;  iz < nz3;  ++iz)
+			for (long iy = 0;  iy < ny3;  ++iy)
+				for (long ix = 0;  ix < nx3;  ++ix)
+					mask[(iz*ny3+iy)*nx3+ix] = (ix < pml || iz < 2*pml) ? 1 : 0;
+		for (int use_local_RMS = 0;  use_local_RMS < 2 && masked_passed;  ++use_local_RMS)
+		{
+			long compressed_length3 = 0l, compressed_length5 = 0l, compressed_length6 = 0l;
+			Compress(scale,vol3,nx3,ny3,nz3,8,8,8,use_local_RMS,(unsigned int*)compressed3,compressed_length3);
+			Decompress(vol5,nx3,ny3,nz3,(unsigned int*)compressed3,compressed_length3);
+			Compress_Masked(scale,vol3,nx3,ny3,nz3,8,8,8,use_local_RMS,0L,2,boxes,-1.0f,compressed5,compressed_length5);
+			Decompress(vol6,nx3,ny3,nz3,compressed5,compressed_length5);
+			for (long iz = 0;  iz < nz3 && masked_passed;  ++iz)
+				for (long iy = 0;  iy < ny3;  ++iy)
+					for (long ix = 0;  ix < nx3;  ++ix)
+					{
+						long idx = (iz*ny3+iy)*nx3+ix;
+						bool excluded = (ix/8+1)*8 <= pml || (iz/8+1)*8 <= 2*pml;
+						masked_passed = masked_passed && vol6[idx] == (excluded ? -1.0f : vol5[idx]);
+					}
+			masked_passed = masked_passed && compressed_length5 < compressed_length3;
+			Compress_Masked(scale,vol3,nx3,ny3,nz3,8,8,8,use_local_RMS,mask,0,0L,-1.0f,compressed6,compressed_length6);
+			masked_passed = masked_passed && compressed_length6 == compressed_length5 && memcmp(compressed5,compressed6,compressed_length5-7) == 0;
+		}
+		// 2D masked streams decode with Decompress_Gathers too.
+		long nxy3 = (long)nx3 * (long)ny3;
+		int box2d[6] = {0,0,0,64,ny3,1};
+		float* gathers[2] = {vol5, vol5 + nxy3};
+		unsigned int* gather_streams[2] = {compressed5, compressed6};
+		long gather_lengths[2];
+		for (int iz = 0;  iz < 2;  ++iz)
+		{
+			Compress_Masked(scale,vol3+iz*nxy3,nx3,ny3,1,32,32,1,iz == 1,0L,1,box2d,-1.0f,gather_streams[iz],gather_lengths[iz]);
+			Decompress(vol6+iz*nxy3,nx3,ny3,1,gather_streams[iz],gather_lengths[iz]);
+		}
+		Decompress_Gathers(gathers,2,nx3,ny3,gather_streams,gather_lengths);
+		masked_passed = masked_passed && vol5[0] == -1.0f && memcmp(vol5,vol6,2*sizeof(float)*nxy3) == 0;
+		delete [] mask;
+		free(compressed5);
+		free(vol5);
+	}
+	if (masked_passed)
+		printf("[\x1B[32mPassed!\x1B[0m]\n");
+	else
+		printf("[\x1B[31mFailed!\x1B[0m]\n");
+
 	if (vol3 != 0L) free(vol3);
 	if (compressed3 != 0L) free(compressed3);
 
@@ -1242,7 +7235,7 @@ bool CvxCompress::Run_Module_Tests(bool verbose, bool exhaustive_throughput_test
 	if (block != 0L) free(block);
 	if (vol != 0L) free(vol);
 
-	return forward_passed && inverse_passed && copy_to_block_passed && copy_from_block_passed && copy_round_trip_passed && global_rms_passed;
+	return forward_passed && inverse_passed && copy_to_block_passed && copy_from_block_passed && copy_round_trip_passed && global_rms_passed && reversible_passed && double_passed && half_passed && padded_passed && z_fast_passed && gathers_passed && batch_passed && delta_passed && four_d_passed && complex_passed && components_passed && given_rms_passed && axpy_passed && dot_passed && accumulate_passed && tiers_passed && transcode_passed && stitch_passed && shards_passed && compact_passed && fixed_passed && adaptive_passed && masked_passed;
 }
 
 //
@@ -1307,6 +7300,23 @@ cvx_compress_th(
 	return c.Compress(scale, vol, nx, ny, nz, bx, by, bz, use_local_RMS, compressed, num_threads, *compressed_length);
 }
 
+float
+cvx_compress_reversible(
+	float         max_error,
+	float        *vol,
+	int           nx,
+	int           ny,
+	int           nz,
+	int           bx,
+	int           by,
+	int           bz,
+	unsigned int *compressed,
+	long         *compressed_length)
+{
+	CvxCompress c;
+	return c.Compress_Reversible(max_error, vol, nx, ny, nz, bx, by, bz, compressed, *compressed_length);
+}
+
 void 
 cvx_decompress_inplace_th(
 	float         *vol,
@@ -3,10 +3,22 @@
 #ifndef CVX_CVXCOMPRESS_HXX
 #define CVX_CVXCOMPRESS_HXX
 
+#ifdef __cplusplus
+#include <complex>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/*!
+ * 16 bit floating point sample types, stored as raw bit patterns.
+ * cvx_float16 is IEEE 754 half precision, cvx_bfloat16 is the upper half of an IEEE 754 single precision float.
+ * Wrapped in structs so that Compress and Decompress can be overloaded on them.
+ */
+typedef struct { unsigned short bits; } cvx_float16;
+typedef struct { unsigned short bits; } cvx_bfloat16;
+
 #ifdef __cplusplus
 
 /*!
@@ -63,6 +75,41 @@ public:
 			unsigned int* compressed,
 			long& compressed_length
 			);
+	/*!
+	 * Same as above with the global RMS passed in and out. A global_rms > 0 is used as is, which skips the full read of the volume
+	 * that computes it, e.g. when the solver already knows the RMS. 0 computes it as usual and returns it in global_rms,
+	 * so it can be passed on to the next snapshot when consecutive snapshots are close enough to share one.
+	 * Ignored and left unchanged with use_local_RMS.
+	 */
+	float Compress(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
+			);
 	/*!
  	 * Compress a 3D wavefield using a given block size.
  	 * Works same as above, except parameter use_local_RMS is hardcoded to be false.
@@ -92,46 +139,1769 @@ public:
 						int num_threads,
                         long& compressed_length
                       );
-	/*!< Decompress a 3D wavefield that was compressed with Compress(...) method */
-
-	float* Decompress(
-			int& nx,
-			int& ny,
-			int& nz,
+	/*!
+	 * Compress a 3D wavefield stored in double precision.
+	 * Same as the float versions, samples are converted to float as blocks are copied in,
+	 * so no float copy of the volume is needed. Decompress with any Decompress method.
+	 */
+	float Compress(
+			float scale,
+			double* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
 			unsigned int* compressed,
-			long compressed_length 
+			int num_threads,
+			long& compressed_length
 			);
-
-	void Decompress(
-			float* vol,
+	float Compress(
+			float scale,
+			double* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like the float version.
+	 */
+	float Compress(
+			float scale,
+			double* vol,
 			int nx,
 			int ny,
 			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
 			unsigned int* compressed,
 			int num_threads,
-			long compressed_length 
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			double* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
 			);
 
-	void Decompress(
-			float* vol,
+	/*!
+	 * Compress a 3D wavefield stored as 16 bit floats (IEEE half precision or bfloat16).
+	 * Samples are converted to float as blocks are copied in. Decompress with any Decompress method.
+	 */
+	float Compress(
+			float scale,
+			cvx_float16* vol,
 			int nx,
 			int ny,
 			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
 			unsigned int* compressed,
-			long compressed_length 
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			cvx_float16* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like the float version.
+	 */
+	float Compress(
+			float scale,
+			cvx_float16* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			cvx_float16* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			cvx_bfloat16* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			cvx_bfloat16* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like the float version.
+	 */
+	float Compress(
+			float scale,
+			cvx_bfloat16* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			cvx_bfloat16* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
 			);
 
-	bool Is_Valid_Block_Size(int bx, int by, int bz);
+	/*!
+	 * Compress a complex valued 3D wavefield, e.g. a monochromatic frequency domain wavefield.
+	 * nx is fast, samples are interleaved real and imaginary parts.
+	 * Both parts are gathered in one pass and go through the block pipeline together, so they share one header,
+	 * one block index and one RMS (global or local). scale is relative to the RMS of the complex samples.
+	 * Decompress with the std::complex<float> Decompress methods.
+	 */
+	float Compress(
+			float scale,
+			std::complex<float>* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			std::complex<float>* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like the float version.
+	 */
+	float Compress(
+			float scale,
+			std::complex<float>* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			std::complex<float>* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
+			);
 
-	static int Min_BX() {return  8;}  /*!< Get minimum X block size. Will always be a power of two.*/
-	static int Max_BX() {return 256;}  /*!< Get maximum X block size. Will always be a power of two.*/
-	static int Min_BY() {return  8;}  /*!< Get minimum Y block size. Will always be a power of two.*/
-	static int Max_BY() {return 256;}  /*!< Get maximum Y block size. Will always be a power of two.*/
-	static int Min_BZ() {return  8;}  /*!< Get minimum Z block size. Will always be a power of two.*/
+	/*!
+	 * Compress a 3D volume with nc interleaved components per sample, e.g. the nine stress and velocity fields
+	 * of an elastic solver stored as vol[((iz*ny+iy)*nx+ix)*nc+ic].
+	 * All components are gathered in one pass and share one header and one block index, but every component
+	 * is quantized against its own RMS (global or local), so components of very different magnitude keep the same relative accuracy.
+	 * Decompress with Decompress_Components.
+	 */
+	float Compress_Components(
+			float scale,
+			float* vol,
+			int nc,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Components(
+			float scale,
+			float* vol,
+			int nc,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress the nx*ny*nz interior of a larger, padded array, e.g. a finite difference grid with halo or PML cells.
+	 * Rows of the array are ldx samples apart and slices are ldy rows apart.
+	 * The first interior sample is vol[(oz*ldy+oy)*ldx+ox], requires ox+nx <= ldx and oy+ny <= ldy.
+	 * The compressed stream only holds the interior and can be decompressed into a packed or a padded array.
+	 */
+	float Compress(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int ldx,
+			int ldy,
+			int ox,
+			int oy,
+			int oz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int ldx,
+			int ldy,
+			int ox,
+			int oy,
+			int oz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like the float version.
+	 */
+	float Compress(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int ldx,
+			int ldy,
+			int ox,
+			int oy,
+			int oz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int ldx,
+			int ldy,
+			int ox,
+			int oy,
+			int oz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress nvol volumes of the same size in one go, e.g. pressure and particle velocities of one time step.
+	 * Volume vols[i] gets its own independent stream in compressed[i] with its length in compressed_length[i],
+	 * each stream is the same as a separate Compress call would produce and decompresses on its own.
+	 * The blocks of all volumes are scheduled over one thread team, with one workspace and one global RMS pass.
+	 * Returns overall compression ratio.
+	 */
+	float Compress_Batch(
+			float scale,
+			const float* const* vols,
+			int nvol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* const* compressed,
+			int num_threads,
+			long* compressed_length
+			);
+	float Compress_Batch(
+			float scale,
+			const float* const* vols,
+			int nvol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* const* compressed,
+			long* compressed_length
+			);
+
+	/*!
+	 * Compress one volume at ntier quality levels in one go, e.g. a high fidelity archive copy and a low fidelity checkpoint.
+	 * Stream compressed[i] is the same as Compress(scale[i],...) would produce, with its length in compressed_length[i].
+	 * Every block is copied in and transformed once, only quantization and run length encoding are repeated per tier.
+	 * Returns overall compression ratio, with the volume counted once per tier.
+	 */
+	float Compress_Tiers(
+			const float* scale,
+			int ntier,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* const* compressed,
+			int num_threads,
+			long* compressed_length
+			);
+	float Compress_Tiers(
+			const float* scale,
+			int ntier,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* const* compressed,
+			long* compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like Compress, all tiers use the same RMS.
+	 */
+	float Compress_Tiers(
+			const float* scale,
+			int ntier,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* const* compressed,
+			int num_threads,
+			long* compressed_length
+			);
+	float Compress_Tiers(
+			const float* scale,
+			int ntier,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* const* compressed,
+			long* compressed_length
+			);
+
+	/*!
+	 * Compress a 3D wavefield stored with z as the fast axis and x as the slow axis (trace-major),
+	 * i.e. sample (ix,iy,iz) is vol[(ix*ny+iy)*nz+iz].
+	 * nx, ny, nz and bx, by, bz refer to the physical axes, so each axis gets its own block size
+	 * (e.g. a longer bz to follow the denser sampling in time or depth).
+	 * Blocks are transposed as they are gathered, the stream is the same as Compress would produce
+	 * for the x-fast copy of the volume. Decompress with Decompress_Z_Fast, or with Decompress to get an x-fast volume.
+	 */
+	float Compress_Z_Fast(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Z_Fast(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like Compress.
+	 */
+	float Compress_Z_Fast(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Z_Fast(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress nt consecutive snapshots of a 3D wavefield as one stream of 4D blocks bx*by*bz*bt.
+	 * Snapshot it starts at vol + it*nx*ny*nz, nx is fast, nt is slow.
+	 * The 7-9 wavelet transform is applied along time as well, which pays off when the snapshots are finely sampled in time.
+	 * bt follows the same rules as bz (multiple of Block_Size_Step() between Min_BZ() and Max_BZ()), or is 1.
+	 * Snapshots past nt in the last time block are zero padded, like the spatial edges.
+	 * The header is extended with nt and bt, decompress with Decompress_4D.
+	 * Returns compression ratio.
+	 */
+	float Compress_4D(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int nt,
+			int bx,
+			int by,
+			int bz,
+			int bt,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_4D(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int nt,
+			int bx,
+			int by,
+			int bz,
+			int bt,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS of all nt snapshots together passed in and out like Compress.
+	 */
+	float Compress_4D(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int nt,
+			int bx,
+			int by,
+			int bz,
+			int bt,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_4D(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int nt,
+			int bx,
+			int by,
+			int bz,
+			int bt,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress a 3D volume losslessly or near-losslessly with the reversible integer 5/3 wavelet transform.
+	 * nx is fast, nz is slow
+	 * max_error is the largest absolute error allowed for any sample.
+	 * max_error=0 is lossless, decompressed volume is bit identical to input (NaN and Inf included).
+	 * max_error>0 is near-lossless, each sample is quantized to a multiple of 2*max_error before the transform,
+	 * so decompressed samples are within max_error of the input (plus float rounding when converted back).
+	 * The mode is recorded in the header flags, so the regular Decompress methods decode these streams too.
+	 * Returns compression ratio.
+	 */
+	float Compress_Reversible(
+			float max_error,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Reversible(
+			float max_error,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress a 3D volume into exactly block_bytes bytes per block, so block i can be found at a fixed offset without a block index.
+	 * nx is fast, nz is slow
+	 * Every block carries its own multiplication factor (global or local RMS as for Compress) in the first 4 bytes of its slot.
+	 * Blocks whose encoded coefficients do not fit in the rest of the slot lose their smallest coefficients until they do.
+	 * block_bytes must be a multiple of 4 and at least 8, 4 + 5/4 of the raw block size is enough for every block to be lossy only from quantization.
+	 * compressed_length is always 40 + nbx*nby*nbz*block_bytes + 7, which is also the room compressed needs.
+	 * The regular Decompress methods decode these streams, Decompress_Block decodes single blocks.
+	 * Returns compression ratio.
+	 */
+	float Compress_Fixed_Size(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			int block_bytes,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Fixed_Size(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			int block_bytes,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like Compress.
+	 */
+	float Compress_Fixed_Size(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			int block_bytes,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Fixed_Size(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			int block_bytes,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress a 3D volume with a block size that adapts to the wavefield.
+	 * nx is fast, nz is slow
+	 * bx, by and bz give the largest blocks, e.g. 64x64x64. Every block is halved along all three axes, up to max_depth times,
+	 * while the RMS of its samples is above split_rms times the global RMS. With max_depth=3, 64^3 blocks in quiet regions
+	 * stay whole and blocks on a wavefront end up as 32^3, 16^3 or 8^3. The smallest blocks must still be valid block sizes.
+	 * split_rms=0 splits every block that is not all zeros, a huge split_rms gives the same blocks as Compress.
+	 * Every leaf of an octree is quantized with the global RMS, or its own RMS with use_local_RMS, and encoded on its own.
+	 * The block index is hierarchical, a range of leaves for every large block and an offset and depth for every leaf.
+	 * Decompress (and Decompress_Batch, Decompress_Z_Fast, Decompress_Accumulate) decode these streams, as does Decompress_Block.
+	 * The block by block operations (Axpy_Compressed, Dot_Compressed, Transcode, Stitch_Compressed...) do not support them.
+	 * Returns compression ratio.
+	 */
+	float Compress_Adaptive(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			int max_depth,
+			float split_rms,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Adaptive(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			int max_depth,
+			float split_rms,
+			bool use_local_RMS,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like Compress.
+	 * It is also used with use_local_RMS, since the global RMS decides where blocks are split.
+	 */
+	float Compress_Adaptive(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			int max_depth,
+			float split_rms,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Adaptive(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			int max_depth,
+			float split_rms,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress a 3D volume, leaving out the blocks that only hold cells the caller will never use,
+	 * e.g. absorbing boundary layers or the water column.
+	 * nx is fast, nz is slow
+	 * A cell is excluded if its byte in mask (nx*ny*nz bytes, x fast) is non zero, or if it lies inside one of the nbox boxes.
+	 * Box i is boxes[6*i+0] <= x < boxes[6*i+3], boxes[6*i+1] <= y < boxes[6*i+4], boxes[6*i+2] <= z < boxes[6*i+5].
+	 * mask may be 0L, and nbox may be 0.
+	 * Blocks whose cells are all excluded are neither transformed nor stored and decode to fill. Other blocks are compressed as usual,
+	 * including any excluded cells in them. The global RMS is that of the whole volume.
+	 * The regular Decompress methods decode these streams. The block by block operations (Axpy_Compressed, Dot_Compressed,
+	 * Transcode, Stitch_Compressed...) do not support them.
+	 * Returns compression ratio.
+	 */
+	float Compress_Masked(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			const unsigned char* mask,
+			int nbox,
+			const int* boxes,
+			float fill,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Masked(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			const unsigned char* mask,
+			int nbox,
+			const int* boxes,
+			float fill,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS passed in and out like Compress. A computed RMS includes the masked cells.
+	 */
+	float Compress_Masked(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			const unsigned char* mask,
+			int nbox,
+			const int* boxes,
+			float fill,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Masked(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			const unsigned char* mask,
+			int nbox,
+			const int* boxes,
+			float fill,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress one snapshot of a time sequence as the residual against a prediction from earlier snapshots.
+	 * prev and prev2 must be the decoded (not the original) previous two snapshots, so encoder and decoder predict from the same reference.
+	 * prev == 0L makes a key frame, which is a regular stream that decodes on its own with Decompress.
+	 * prev2 == 0L predicts the snapshot by prev, otherwise by the linear extrapolation 2*prev-prev2.
+	 * scale is relative to the global RMS of the snapshot itself, so residual frames have the same quality as key frames.
+	 * decoded receives the decoded snapshot, which is the prev for the next call. Pass 0L if it is not needed.
+	 * decoded must not overlap vol, prev or prev2.
+	 * The stream layout is the same as for Compress, the predictor is recorded in the header flags.
+	 * Decompress with Decompress_Delta, the other Decompress methods reject residual frames. Returns compression ratio.
+	 */
+	float Compress_Delta(
+			float scale,
+			float* vol,
+			const float* prev,
+			const float* prev2,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			unsigned int* compressed,
+			float* decoded,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Delta(
+			float scale,
+			float* vol,
+			const float* prev,
+			const float* prev2,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			unsigned int* compressed,
+			float* decoded,
+			long& compressed_length
+			);
+	/*!
+	 * Same as above with the global RMS of the snapshot vol (not of the residual) passed in and out like Compress.
+	 */
+	float Compress_Delta(
+			float scale,
+			float* vol,
+			const float* prev,
+			const float* prev2,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			float& global_rms,
+			unsigned int* compressed,
+			float* decoded,
+			int num_threads,
+			long& compressed_length
+			);
+	float Compress_Delta(
+			float scale,
+			float* vol,
+			const float* prev,
+			const float* prev2,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			float& global_rms,
+			unsigned int* compressed,
+			float* decoded,
+			long& compressed_length
+			);
+
+	/*!< Decompress a 3D wavefield that was compressed with Compress(...) method */
+
+	float* Decompress(
+			int& nx,
+			int& ny,
+			int& nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	void Decompress(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+
+	void Decompress(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress a 3D wavefield into a double precision volume.
+	 */
+	void Decompress(
+			double* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+
+	void Decompress(
+			double* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress a 3D wavefield straight into 16 bit floats (IEEE half precision or bfloat16).
+	 * Samples are rounded to nearest even, values too large for half precision become Inf.
+	 */
+	void Decompress(
+			cvx_float16* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress(
+			cvx_float16* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+	void Decompress(
+			cvx_bfloat16* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress(
+			cvx_bfloat16* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress a complex valued 3D wavefield that was compressed with the std::complex<float> Compress methods.
+	 */
+	void Decompress(
+			std::complex<float>* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress(
+			std::complex<float>* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress a volume with nc interleaved components per sample that was compressed with Compress_Components.
+	 */
+	void Decompress_Components(
+			float* vol,
+			int nc,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length
+			);
+	void Decompress_Components(
+			float* vol,
+			int nc,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length
+			);
+
+	/*!
+	 * Decompress into the nx*ny*nz interior of a larger, padded array.
+	 * ldx, ldy, ox, oy and oz have the same meaning as for the padded Compress method. Cells outside the interior are not touched.
+	 */
+	void Decompress(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int ldx,
+			int ldy,
+			int ox,
+			int oy,
+			int oz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int ldx,
+			int ldy,
+			int ox,
+			int oy,
+			int oz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress nvol streams of the same volume size and block size, compressed[i] goes to vols[i].
+	 * Blocks of all streams are scheduled over one thread team with one workspace.
+	 */
+	void Decompress_Batch(
+			float* const* vols,
+			int nvol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* const* compressed,
+			int num_threads,
+			const long* compressed_length 
+			);
+	void Decompress_Batch(
+			float* const* vols,
+			int nvol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* const* compressed,
+			const long* compressed_length 
+			);
+
+	/*!
+	 * Decompress into a volume stored with z as the fast axis, see Compress_Z_Fast.
+	 * Works for any stream, including ones made by Compress from an x-fast volume.
+	 */
+	void Decompress_Z_Fast(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress_Z_Fast(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress and add the result to an existing volume, vol += alpha * decoded.
+	 * Blocks are accumulated as they are decoded, so no temporary full-size volume is needed.
+	 */
+	void Decompress_Accumulate(
+			float* vol,
+			float alpha,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress_Accumulate(
+			float* vol,
+			float alpha,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress and multiply the result into another volume, img += src * decoded.
+	 * This is the cross-correlation imaging condition with a compressed source wavefield.
+	 * src and img have dimensions nx*ny*nz, img must not overlap src.
+	 */
+	void Decompress_Multiply_Accumulate(
+			float* img,
+			const float* src,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress_Multiply_Accumulate(
+			float* img,
+			const float* src,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress nt snapshots that were compressed with Compress_4D.
+	 */
+	void Decompress_4D(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int nt,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress_4D(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int nt,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Decompress the single block ix,iy,iz of a 3D stream into blk, which receives bx*by*bz samples with x fast.
+	 * Samples of a block that sticks out of the volume past nx, ny or nz are not written.
+	 * Streams from Compress_Fixed_Size locate the block without an index, other streams look it up in their block index.
+	 * For streams from Compress_Adaptive this is the bx*by*bz block of the coarse grid, assembled from its octree leaves.
+	 * work must hold bx*by*bz + 8*MAX(bx,by,bz) floats and be aligned on a 32 byte boundary. Pass one per thread when
+	 * decoding many blocks, the overload without work allocates it on every call.
+	 */
+	void Decompress_Block(
+			float* blk,
+			int ix,
+			int iy,
+			int iz,
+			unsigned int* compressed
+			);
+	void Decompress_Block(
+			float* blk,
+			int ix,
+			int iy,
+			int iz,
+			unsigned int* compressed,
+			float* work
+			);
+
+	/*!
+	 * Decompress a snapshot made by Compress_Delta.
+	 * prev and prev2 are the decoded previous snapshots that were passed to Compress_Delta, they are only read if the stream needs them.
+	 * Key frames need neither. vol must not overlap prev or prev2.
+	 */
+	void Decompress_Delta(
+			float* vol,
+			const float* prev,
+			const float* prev2,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long compressed_length 
+			);
+	void Decompress_Delta(
+			float* vol,
+			const float* prev,
+			const float* prev2,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long compressed_length 
+			);
+
+	/*!
+	 * Compress a batch of 2D gathers of the same size, e.g. thousands of shot or receiver gathers.
+	 * nx is fast, sample (ix,iy) of gather i is gathers[i][iy*nx+ix].
+	 * Each gather gets its own stream in compressed[i] with its length in compressed_length[i].
+	 * The streams are the same as Compress(scale,gathers[i],nx,ny,1,bx,by,1,...) would produce.
+	 * Whole gathers are handed out to threads, so small blocks do not pay for any synchronization.
+	 * Returns overall compression ratio.
+	 */
+	float Compress_Gathers(
+			float scale,
+			const float* const* gathers,
+			int ngathers,
+			int nx,
+			int ny,
+			int bx,
+			int by,
+			bool use_local_RMS,
+			unsigned int* const* compressed,
+			int num_threads,
+			long* compressed_length
+			);
+	float Compress_Gathers(
+			float scale,
+			const float* const* gathers,
+			int ngathers,
+			int nx,
+			int ny,
+			int bx,
+			int by,
+			bool use_local_RMS,
+			unsigned int* const* compressed,
+			long* compressed_length
+			);
+
+	/*!
+	 * Decompress a batch of 2D gathers. Besides streams made by Compress_Gathers, 2D streams from Compress, Compress_Fixed_Size and Compress_Masked
+	 * can be decoded, blocks left out by Compress_Masked decode to its fill value. Delta, 4D, component and adaptive streams are rejected.
+	 */
+	void Decompress_Gathers(
+			float* const* gathers,
+			int ngathers,
+			int nx,
+			int ny,
+			unsigned int* const* compressed,
+			int num_threads,
+			const long* compressed_length
+			);
+	void Decompress_Gathers(
+			float* const* gathers,
+			int ngathers,
+			int nx,
+			int ny,
+			unsigned int* const* compressed,
+			const long* compressed_length
+			);
+
+	/*!
+	 * Compute C = alpha*A + beta*B from two compressed volumes without decompressing them, e.g. to stack partial images.
+	 * A and B must have the same shape, block size and layout, i.e. come from the same kind of Compress call, and must not be reversible
+	 * or come from Compress_Delta. Blocks are combined on their decoded wavelet coefficients and requantized with scale and use_local_RMS
+	 * like Compress would, so no transforms are run. A global RMS is estimated from the energy of the combined coefficients
+	 * in one extra pass that only run length decodes the blocks, the overloads with global_rms below can skip that pass.
+	 * The estimate is within about a percent of the RMS of the decompressed C.
+	 * C has the layout of A and is decompressed with the matching Decompress method. C must not overlap A or B.
+	 * Each call requantizes, so a long running sum accumulates one quantization error per call.
+	 * Returns compression ratio of C.
+	 */
+	float Axpy_Compressed(
+			float alpha,
+			unsigned int* A,
+			long A_length,
+			float beta,
+			unsigned int* B,
+			long B_length,
+			float scale,
+			bool use_local_RMS,
+			unsigned int* C,
+			int num_threads,
+			long& C_length
+			);
+	float Axpy_Compressed(
+			float alpha,
+			unsigned int* A,
+			long A_length,
+			float beta,
+			unsigned int* B,
+			long B_length,
+			float scale,
+			bool use_local_RMS,
+			unsigned int* C,
+			long& C_length
+			);
+	/*!
+	 * Same as above with the global RMS of C passed in and out. A global_rms > 0 is used as is, 0 estimates it as above and returns it.
+	 * Ignored and left unchanged with use_local_RMS or when A has per component RMS.
+	 */
+	float Axpy_Compressed(
+			float alpha,
+			unsigned int* A,
+			long A_length,
+			float beta,
+			unsigned int* B,
+			long B_length,
+			float scale,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* C,
+			int num_threads,
+			long& C_length
+			);
+	float Axpy_Compressed(
+			float alpha,
+			unsigned int* A,
+			long A_length,
+			float beta,
+			unsigned int* B,
+			long B_length,
+			float scale,
+			bool use_local_RMS,
+			float& global_rms,
+			unsigned int* C,
+			long& C_length
+			);
+
+	/*!
+	 * Requantize a compressed volume with a new scale, e.g. to move it to a colder storage tier at a higher compression ratio.
+	 * The run length encoded blocks are decoded to wavelet coefficients and re-encoded, no transforms are run.
+	 * The output keeps the block size, layout and local or global RMS mode of the input and is the same kind of stream.
+	 * A global RMS is estimated from the energy of the coefficients like Axpy_Compressed does, or passed in with the overloads with global_rms.
+	 * Reversible streams and streams from Compress_Delta are not supported. compressed_out must not overlap compressed_in.
+	 * Returns compression ratio of the output.
+	 */
+	float Transcode(
+			float new_scale,
+			unsigned int* compressed_in,
+			long in_length,
+			unsigned int* compressed_out,
+			int num_threads,
+			long& out_length
+			);
+	float Transcode(
+			float new_scale,
+			unsigned int* compressed_in,
+			long in_length,
+			unsigned int* compressed_out,
+			long& out_length
+			);
+	/*!
+	 * Same as above with the global RMS of the output passed in and out. A global_rms > 0 is used as is, 0 estimates it as above
+	 * and returns it. Ignored and left unchanged for streams with local or per component RMS.
+	 */
+	float Transcode(
+			float new_scale,
+			unsigned int* compressed_in,
+			long in_length,
+			float& global_rms,
+			unsigned int* compressed_out,
+			int num_threads,
+			long& out_length
+			);
+	float Transcode(
+			float new_scale,
+			unsigned int* compressed_in,
+			long in_length,
+			float& global_rms,
+			unsigned int* compressed_out,
+			long& out_length
+			);
+
+	/*!
+	 * Assemble the stream of an nx*ny*nz volume from npiece streams of subvolumes without decoding them,
+	 * e.g. the pieces compressed by the ranks of a domain decomposed solver.
+	 * Piece ip is a stream of a subvolume whose first sample is at x0[ip],y0[ip],z0[ip] of the volume.
+	 * Pieces must have the same block size and layout, start on a block boundary and end on one unless they end at the edge of the volume,
+	 * and must cover the volume without overlapping. Only the header and block index are rewritten, the encoded blocks are copied.
+	 * Pieces compressed with different global RMS values get their factors stored per block, like local RMS streams.
+	 * Pass a common RMS to the Compress overloads with global_rms for every piece to avoid that. Reversible pieces must have the same quantization step.
+	 * compressed must have room for the sum of the piece lengths plus 4*nc bytes per block.
+	 * If compressed is 0L only compressed_length is set to the room the output needs, the stream itself can be a little shorter.
+	 * Returns compression ratio of the assembled stream.
+	 */
+	float Stitch_Compressed(
+			unsigned int* const* pieces,
+			const long* piece_length,
+			const int* x0,
+			const int* y0,
+			const int* z0,
+			int npiece,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			int num_threads,
+			long& compressed_length
+			);
+	float Stitch_Compressed(
+			unsigned int* const* pieces,
+			const long* piece_length,
+			const int* x0,
+			const int* y0,
+			const int* z0,
+			int npiece,
+			int nx,
+			int ny,
+			int nz,
+			unsigned int* compressed,
+			long& compressed_length
+			);
+
+	/*!
+	 * Compress a 3D wavefield into nshard independently decodable shards, e.g. for concurrent writers and readers on a parallel file system.
+	 * Shard i holds a contiguous range of whole block layers along z and is the regular stream of that nx*ny slab of the volume,
+	 * written to shards[i] with its length in shard_length[i]. All shards are quantized against the RMS of the whole volume.
+	 * manifest receives 4 + 3*nshard values: nx, ny, nz, nshard, then the first z slice, number of z slices and length of every shard.
+	 * nshard can be at most the number of block layers along z. Decompress with Decompress_Shard or Decompress_Shards,
+	 * or join the shards into one stream with Stitch_Compressed. Returns overall compression ratio.
+	 */
+	float Compress_Shards(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			int nshard,
+			unsigned int* const* shards,
+			int num_threads,
+			long* shard_length,
+			long* manifest
+			);
+	float Compress_Shards(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			int nshard,
+			unsigned int* const* shards,
+			long* shard_length,
+			long* manifest
+			);
+	/*!
+	 * Same as above with the global RMS of the whole volume passed in and out like Compress.
+	 */
+	float Compress_Shards(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			int nshard,
+			unsigned int* const* shards,
+			int num_threads,
+			long* shard_length,
+			long* manifest
+			);
+	float Compress_Shards(
+			float scale,
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			int bx,
+			int by,
+			int bz,
+			bool use_local_RMS,
+			float& global_rms,
+			int nshard,
+			unsigned int* const* shards,
+			long* shard_length,
+			long* manifest
+			);
+
+	/*!
+	 * Decompress shard ishard made by Compress_Shards into its slab of the nx*ny*nz volume, the rest of vol is not touched.
+	 * Shards can be decompressed in any order as they arrive.
+	 */
+	void Decompress_Shard(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			const long* manifest,
+			int ishard,
+			unsigned int* shard,
+			int num_threads,
+			long shard_length
+			);
+	void Decompress_Shard(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			const long* manifest,
+			int ishard,
+			unsigned int* shard,
+			long shard_length
+			);
+
+	/*!
+	 * Decompress all shards made by Compress_Shards.
+	 */
+	void Decompress_Shards(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			const long* manifest,
+			unsigned int* const* shards,
+			int num_threads,
+			const long* shard_length
+			);
+	void Decompress_Shards(
+			float* vol,
+			int nx,
+			int ny,
+			int nz,
+			const long* manifest,
+			unsigned int* const* shards,
+			const long* shard_length
+			);
+
+	/*!
+	 * Dot product <A,B> of two compressed volumes estimated from their quantized wavelet coefficients,
+	 * e.g. for the zero lag cross-correlation imaging condition. A and B must have the same shape, block size and layout,
+	 * reversible streams and streams from Compress_Delta are not supported.
+	 * Blocks are only run length decoded, the inverse transform is skipped. Products of coefficients are weighted with
+	 * the Gram matrix of the 7-9 synthesis functions, which is kept in full for the coarse coefficients of a block and
+	 * only where it is significant for the rest. The estimate is usually within half a percent of the dot product of the
+	 * decompressed volumes and a few percent per block. It is 2-3x faster than Dot_Compressed_Exact with 32^3 and 64^3 blocks,
+	 * about as fast with 16^3 blocks and slower with 8^3 blocks, where the inverse transform is cheap.
+	 */
+	double Dot_Compressed(
+			unsigned int* A,
+			long A_length,
+			unsigned int* B,
+			long B_length,
+			int num_threads
+			);
+	double Dot_Compressed(
+			unsigned int* A,
+			long A_length,
+			unsigned int* B,
+			long B_length
+			);
+
+	/*!
+	 * Dot product <A,B> of the decompressed volumes, to within double precision rounding. Slower than Dot_Compressed,
+	 * every block is decoded and inverse transformed in a small per thread work area, but no volume is written or read back.
+	 * Reversible streams are supported.
+	 */
+	double Dot_Compressed_Exact(
+			unsigned int* A,
+			long A_length,
+			unsigned int* B,
+			long B_length,
+			int num_threads
+			);
+	double Dot_Compressed_Exact(
+			unsigned int* A,
+			long A_length,
+			unsigned int* B,
+			long B_length
+			);
+
+	/*!
+	 * L2 norm of a compressed volume, sqrt(<A,A>) estimated like Dot_Compressed. sqrt(Dot_Compressed_Exact(A,A)) gives the exact norm.
+	 */
+	double Norm_Compressed(
+			unsigned int* A,
+			long A_length,
+			int num_threads
+			);
+	double Norm_Compressed(
+			unsigned int* A,
+			long A_length
+			);
+
+	/*!
+	 * Energy (sum of squares) of every block of a compressed volume, estimated like Dot_Compressed.
+	 * energy must have room for one value per block, nbx*nby*nbz*nbt where nbx = (nx+bx-1)/bx etc. and nbt = 1 for 3D volumes.
+	 * Blocks are ordered with x fastest, then y, z and t.
+	 */
+	void Block_Energy_Compressed(
+			unsigned int* A,
+			long A_length,
+			double* energy,
+			int num_threads
+			);
+	void Block_Energy_Compressed(
+			unsigned int* A,
+			long A_length,
+			double* energy
+			);
+
+	/*!
+	 * Check if block size is supported.
+	 * Each block dimension must be a multiple of Block_Size_Step() between the minimum and maximum for that axis.
+	 * bz can also be 1, which selects 2D compression.
+	 */
+	bool Is_Valid_Block_Size(int bx, int by, int bz);
+
+	static int Min_BX() {return  8;}  /*!< Get minimum X block size. Will always be a power of two.*/
+	static int Max_BX() {return 256;}  /*!< Get maximum X block size. Will always be a power of two.*/
+	static int Min_BY() {return  8;}  /*!< Get minimum Y block size. Will always be a power of two.*/
+	static int Max_BY() {return 256;}  /*!< Get maximum Y block size. Will always be a power of two.*/
+	static int Min_BZ() {return  8;}  /*!< Get minimum Z block size. Will always be a power of two.*/
 	static int Max_BZ() {return 256;}  /*!< Get maximum Z block size. Will always be a power of two.*/
+	static int Block_Size_Step() {return 8;}  /*!< Block sizes must be a multiple of this. Need not be a power of two, e.g. 24 or 40 is fine.*/
 
 	bool Run_Module_Tests(bool verbose, bool exhaustive_throughput_tests);  /*!< Execute module tests.*/
 
+	/*!
+	 * Select wavelet transform engine used by Compress and Decompress.
+	 * false (default) uses the convolution kernels, true uses the lifting factorization of the same filter for blocks with
+	 * bx*by*bz >= 262144 (64^3) samples. Smaller blocks keep the convolution kernels, lifting is slower there.
+	 * Module test 4 times both: lifting is 28% and 11% slower at 8^3 and 16^3, about equal at 32^3 and 64^3 and only faster
+	 * at 128^3 and 256^3.
+	 * Both engines produce the same coefficients to within float rounding, so the choice does not affect the compressed format.
+	 */
+	void Set_Use_Lifting(bool use_lifting) {_use_lifting = use_lifting;}
+	bool Get_Use_Lifting() {return _use_lifting;}
+
+private:
+	bool _use_lifting;
+
 };
 
 #endif // __cplusplus
@@ -181,6 +1951,19 @@ float cvx_compress_th(
     long* compressed_length
 );
 
+float cvx_compress_reversible(
+    float max_error,
+    float* vol,
+    int nx,
+    int ny,
+    int nz,
+    int bx,
+    int by,
+    int bz,
+    unsigned int* compressed,
+    long* compressed_length
+);
+
 void cvx_decompress_inplace_th(
     float* vol,
     int nx,
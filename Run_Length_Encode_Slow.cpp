@@ -526,6 +526,106 @@ int Run_Length_Decode_Slow(float scale, float* vals, int num_expected_vals, unsi
 	return num;
 }
 
+/*
+ * Run length encode a block of integers, e.g. coefficients from the reversible transform.
+ * Uses the same escape codes as Run_Length_Encode_Slow, except that VLESC4 is followed by the raw 32 bit integer.
+ * The encoded block can be up to 25% larger than the input, so size compressed like for Run_Length_Encode_Slow.
+ */
+void Run_Length_Encode_Int(int* vals, int num, unsigned long* compressed, int& bytepos)
+{
+	int rle = 0;
+	char* dst = (char*)compressed;
+	for (int i = 0;  i < num;  ++i)
+	{
+		int ival = vals[i];
+		if (ival == 0)
+		{
+			++rle;
+		}
+		else
+		{
+			EncodeRLE_Slow(rle,dst,bytepos);
+			if (ival > VLESC2 && ival < RLESC3)
+			{
+				dst[bytepos++] = (char)ival;
+			}
+			else if (ival >= -32768 && ival <= 32767)
+			{
+				*((int*)(dst+bytepos)) = (VLESC2 & 0xFF) | ((ival & 0xFFFF) << 8);
+				bytepos += 3;
+			}
+			else if (ival >= -8388608 && ival <= 8388607)
+			{
+				*((int*)(dst+bytepos)) = (VLESC3 & 0xFF) | ((ival & 0xFFFFFF) << 8);
+				bytepos += 4;
+			}
+			else
+			{
+				dst[bytepos++] = (char)VLESC4;
+				*((int*)(dst+bytepos)) = ival;
+				bytepos += 4;
+			}
+		}
+	}
+	EncodeRLE_Slow(rle,dst,bytepos);
+}
+
+int Run_Length_Decode_Int(int* vals, int num_expected_vals, unsigned long* compressed)
+{
+	int num = 0;
+	char* p = (char*)compressed;
+	for (;  num < num_expected_vals;  ++p)
+	{
+		int ival = (signed char)*p;
+		if (ival > VLESC2 && ival < RLESC3)
+		{
+			vals[num++] = ival;
+		}
+		else if (ival == RLESC1)
+		{
+			int rle = ((unsigned char*)p)[1];
+			for (int j = 0;  j < rle;  ++j) vals[num+j] = 0;
+			num += rle;
+			p += 1;
+		}
+		else if (ival == RLESC3)
+		{
+			int rle = *((unsigned int*)p) >> 8;
+			for (int j = 0;  j < rle;  ++j) vals[num+j] = 0;
+			num += rle;
+			p += 3;
+		}
+		else if (ival == VLESC2)
+		{
+			vals[num++] = *((short*)(p+1));
+			p += 2;
+		}
+		else if (ival == VLESC3)
+		{
+			vals[num++] = *((int*)p) >> 8;
+			p += 3;
+		}
+		else if (ival == VLESC2_8x)
+		{
+			for (int j = 0;  j < 8;  ++j) vals[num+j] = ((short*)(p+1))[j];
+			num += 8;
+			p += 16;
+		}
+		else if (ival == VLESC3_8x)
+		{
+			for (int j = 0;  j < 8;  ++j) vals[num+j] = *((int*)(p+3*j)) >> 8;
+			num += 8;
+			p += 24;
+		}
+		else if (ival == VLESC4)
+		{
+			vals[num++] = *((int*)(p+1));
+			p += 4;
+		}
+	}
+	return num;
+}
+
 bool Run_Length_Encode_Compare(unsigned long* compressed, int bytepos, unsigned long* compressed2, int bytepos2)
 {
 	bool retval = false;
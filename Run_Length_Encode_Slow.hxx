@@ -36,6 +36,30 @@ Run_Length_Decode_Slow(
 		unsigned long* compressed
 		);
 
+/*!
+ * Run length encode a block of integers without quantization.
+ * Used for reversible compression. Same escape codes as Run_Length_Encode_Slow,
+ * but values that need more than 24 bits are stored as raw integers.
+ */
+void
+Run_Length_Encode_Int(
+	int* vals,
+	int num,
+	unsigned long* compressed,
+	int& bytepos
+	);
+
+/*!
+ * Decode array of integers that was encoded with Run_Length_Encode_Int.
+ *
+ */
+int
+Run_Length_Decode_Int(
+		int* vals,
+		int num_expected_vals,
+		unsigned long* compressed
+		);
+
 /*!
  * Compare two run length encoded blocks.
  * Used in module tests, to compare results from fast and slow run length encoder.
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CvxCompress.hxx"
+
+/*!
+ * Assemble the compressed stream of a volume from compressed subvolumes, e.g. the output of the ranks of a domain decomposed solver.
+ * Each piece file holds one stream as written by Compress, see CvxCompress::Stitch_Compressed for the requirements on the pieces.
+ */
+
+void PrintUsage(const char* cmd)
+{
+	printf("Usage: %s <nx> <ny> <nz> <output-file> <x0> <y0> <z0> <piece-file> [<x0> <y0> <z0> <piece-file> ...]\n",cmd);
+	printf("x0, y0 and z0 are the location of the first sample of the piece in the volume.\n");
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 9 || ((argc - 5) % 4) != 0)
+	{
+		PrintUsage(argv[0]);
+		return -1;
+	}
+
+	int nx = atoi(argv[1]);
+	int ny = atoi(argv[2]);
+	int nz = atoi(argv[3]);
+	if (nx <= 0 || ny <= 0 || nz <= 0)
+	{
+		printf("Bad volume dimensions %d by %d by %d.\n",nx,ny,nz);
+		PrintUsage(argv[0]);
+		return -2;
+	}
+
+	int npiece = (argc - 5) / 4;
+	unsigned int** pieces = new unsigned int*[npiece];
+	long* piece_length = new long[npiece];
+	int* x0 = new int[npiece];
+	int* y0 = new int[npiece];
+	int* z0 = new int[npiece];
+	for (int ip = 0;  ip < npiece;  ++ip)
+	{
+		x0[ip] = atoi(argv[5+4*ip]);
+		y0[ip] = atoi(argv[6+4*ip]);
+		z0[ip] = atoi(argv[7+4*ip]);
+		const char* filename = argv[8+4*ip];
+		FILE* fp = fopen(filename, "rb");
+		if (fp == 0L)
+		{
+			printf("Unable to open %s for reading.\n",filename);
+			return -3;
+		}
+		fseek(fp,0,SEEK_END);
+		piece_length[ip] = ftell(fp);
+		fseek(fp,0,SEEK_SET);
+		// decoders may read a few bytes past the end of a stream.
+		posix_memalign((void**)&pieces[ip], 64, piece_length[ip] + 64);
+		memset(pieces[ip], 0, piece_length[ip] + 64);
+		if (fread(pieces[ip],1,piece_length[ip],fp) != (size_t)piece_length[ip])
+		{
+			printf("Unable to read %s.\n",filename);
+			return -3;
+		}
+		fclose(fp);
+	}
+
+	CvxCompress compressor;
+	long compressed_length = 0;
+	compressor.Stitch_Compressed(pieces,piece_length,x0,y0,z0,npiece,nx,ny,nz,0L,compressed_length);
+	unsigned int* compressed = 0L;
+	posix_memalign((void**)&compressed, 64, compressed_length + 64);
+	float ratio = compressor.Stitch_Compressed(pieces,piece_length,x0,y0,z0,npiece,nx,ny,nz,compressed,compressed_length);
+
+	FILE* fp = fopen(argv[4], "wb");
+	if (fp == 0L)
+	{
+		printf("Unable to open %s for writing.\n",argv[4]);
+		PrintUsage(argv[0]);
+		return -4;
+	}
+	fwrite(compressed,1,compressed_length,fp);
+	fclose(fp);
+	printf("Stitched %d pieces into %s, %ld bytes, compression ratio %.2f:1\n",npiece,argv[4],compressed_length,ratio);
+
+	free(compressed);
+	for (int ip = 0;  ip < npiece;  ++ip) free(pieces[ip]);
+	delete [] z0;
+	delete [] y0;
+	delete [] x0;
+	delete [] piece_length;
+	delete [] pieces;
+	return 0;
+}
@@ -1,7 +1,7 @@
 //
 // This code implements a fast 3D wavelet transform based on Antonini's 7-9 tap filter.
 // This code performs the same functions as the subroutine ChvDs79 in Ergas et.al. ChvCompress code.
-// In order to get maximum performance out of the code, only block sizes that are powers of two
+// In order to get maximum performance out of the code, only block sizes that are multiples of 8
 // between 8 and 256 are supported.
 // This means the smallest supported block is 8x8x8 and the largest is 256x256x256.
 //
@@ -10,6 +10,18 @@
 #include "Ds79_Base.cpp"
 #include "Us79_Base.cpp"
 
+/*
+ * Get lengths of the successive transforms that make up a wavelet transform of length n.
+ * Each transform is applied to the low band of the previous one, so lengths are n, n-n/2, ... down to 2.
+ * Returns number of lengths written to lens.
+ */
+static inline int Get_Transform_Lengths(int n, int* lens)
+{
+	int nlens = 0;
+	for (;  n >= 2;  n = n-n/2) lens[nlens++] = n;
+	return nlens;
+}
+
 void Wavelet_Transform_Fast_Forward(
 	__m256* work,
 	__m256* tmp,
@@ -21,6 +33,10 @@ void Wavelet_Transform_Fast_Forward(
 	int _mm_bx = bx >> 2;
 	int _mm256_bx = bx >> 3;
 	int _mm256_stride_y = _mm256_bx;
+	int lx[16], ly[16], lz[16];
+	int nlx = Get_Transform_Lengths(bx,lx);
+	int nly = Get_Transform_Lengths(by,ly);
+	int nlz = Get_Transform_Lengths(bz,lz);
 	for (int iz = 0;  iz < bz;  ++iz)
         {
 		// x
@@ -45,14 +61,7 @@ void Wavelet_Transform_Fast_Forward(
 				tmp[ix*4+3] = _mm256_insertf128_ps(_mm256_castps128_ps256(v3),v7,1);
 			}
 		
-			if (bx >= 256) _Ds79_AVX_256(tmp, 1);
-			if (bx >= 128) _Ds79_AVX_128(tmp, 1);
-			if (bx >= 64) _Ds79_AVX_64(tmp, 1);
-			if (bx >= 32) _Ds79_AVX_32(tmp, 1);
-			if (bx >= 16) _Ds79_AVX_16(tmp, 1);
-			_Ds79_AVX_8(tmp,1);
-			_Ds79_AVX_4(tmp,1);
-			_Ds79_AVX_2(tmp,1);
+			for (int i = 0;  i < nlx;  ++i) _Ds79_AVX(tmp, 1, lx[i]);
 
 			for (int ix = 0;  ix < _mm_bx;  ++ix)
 			{
@@ -85,14 +94,7 @@ void Wavelet_Transform_Fast_Forward(
 		__m256* data = work + iz*by*_mm256_bx;
 		for (int ix = 0;  ix < _mm256_bx;  ++ix)
 		{
-			if (by >= 256) _Ds79_AVX_256(data+ix, _mm256_stride_y);
-			if (by >= 128) _Ds79_AVX_128(data+ix, _mm256_stride_y);
-			if (by >= 64) _Ds79_AVX_64(data+ix, _mm256_stride_y);
-			if (by >= 32) _Ds79_AVX_32(data+ix, _mm256_stride_y);
-			if (by >= 16) _Ds79_AVX_16(data+ix, _mm256_stride_y);
-			_Ds79_AVX_8(data+ix, _mm256_stride_y);
-			_Ds79_AVX_4(data+ix, _mm256_stride_y);
-			_Ds79_AVX_2(data+ix, _mm256_stride_y);
+			for (int i = 0;  i < nly;  ++i) _Ds79_AVX(data+ix, _mm256_stride_y, ly[i]);
 		}
 	}
 	
@@ -113,15 +115,7 @@ void Wavelet_Transform_Fast_Forward(
 				{
 					for (int iz = 0;  iz < bz;  ++iz) tmp[iz] = data[iz*_mm256_stride_z+ix];
 
-					if (bz >= 256) _Ds79_AVX_256(tmp, 1);
-					if (bz >= 128) _Ds79_AVX_128(tmp, 1);
-					if (bz >= 64) _Ds79_AVX_64(tmp, 1);
-					if (bz >= 32) _Ds79_AVX_32(tmp, 1);
-					if (bz >= 16) _Ds79_AVX_16(tmp, 1);
-					// smallest block size is 8, so no need to test for anything less than that.
-					_Ds79_AVX_8(tmp, 1);
-					_Ds79_AVX_4(tmp, 1);
-					_Ds79_AVX_2(tmp, 1);
+					for (int i = 0;  i < nlz;  ++i) _Ds79_AVX(tmp, 1, lz[i]);
 
 					for (int iz = 0;  iz < bz;  ++iz) data[iz*_mm256_stride_z+ix] = tmp[iz];
 				}
@@ -130,15 +124,7 @@ void Wavelet_Transform_Fast_Forward(
 			{
 				for (int ix = 0;  ix < _mm256_bx;  ++ix)
 				{
-					if (bz >= 256) _Ds79_AVX_256(data+ix, _mm256_stride_z);
-					if (bz >= 128) _Ds79_AVX_128(data+ix, _mm256_stride_z);
-					if (bz >= 64) _Ds79_AVX_64(data+ix, _mm256_stride_z);
-					if (bz >= 32) _Ds79_AVX_32(data+ix, _mm256_stride_z);
-					if (bz >= 16) _Ds79_AVX_16(data+ix, _mm256_stride_z);
-					// smallest block size is 8, so no need to test for anything less than that.
-					_Ds79_AVX_8(data+ix, _mm256_stride_z);
-					_Ds79_AVX_4(data+ix, _mm256_stride_z);
-					_Ds79_AVX_2(data+ix, _mm256_stride_z);
+					for (int i = 0;  i < nlz;  ++i) _Ds79_AVX(data+ix, _mm256_stride_z, lz[i]);
 				}
 			}
 		}
@@ -156,6 +142,10 @@ void Wavelet_Transform_Fast_Inverse(
 	int _mm_bx = bx >> 2;
 	int _mm256_bx = bx >> 3;
 	int _mm256_stride_y = _mm256_bx;
+	int lx[16], ly[16], lz[16];
+	int nlx = Get_Transform_Lengths(bx,lx);
+	int nly = Get_Transform_Lengths(by,ly);
+	int nlz = Get_Transform_Lengths(bz,lz);
 	for (int iz = 0;  iz < bz;  ++iz)
         {
 		// x
@@ -180,14 +170,7 @@ void Wavelet_Transform_Fast_Inverse(
 				tmp[ix*4+3] = _mm256_insertf128_ps(_mm256_castps128_ps256(v3),v7,1);
 			}
 
-			_Us79_AVX_2(tmp,1);
-			_Us79_AVX_4(tmp,1);
-			_Us79_AVX_8(tmp,1);
-			if (bx >= 16) _Us79_AVX_16(tmp,1);
-			if (bx >= 32) _Us79_AVX_32(tmp,1);
-			if (bx >= 64) _Us79_AVX_64(tmp,1);
-			if (bx >= 128) _Us79_AVX_128(tmp,1);
-			if (bx >= 256) _Us79_AVX_256(tmp,1);
+			for (int i = nlx-1;  i >= 0;  --i) _Us79_AVX(tmp, 1, lx[i]);
 
 			for (int ix = 0;  ix < _mm_bx;  ++ix)
 			{
@@ -220,14 +203,7 @@ void Wavelet_Transform_Fast_Inverse(
 		__m256* data = work + iz*by*_mm256_bx;
 		for (int ix = 0;  ix < _mm256_bx;  ++ix)
 		{
-			_Us79_AVX_2(data+ix, _mm256_stride_y);
-			_Us79_AVX_4(data+ix, _mm256_stride_y);
-			_Us79_AVX_8(data+ix, _mm256_stride_y);
-			if (by >= 16) _Us79_AVX_16(data+ix, _mm256_stride_y);
-			if (by >= 32) _Us79_AVX_32(data+ix, _mm256_stride_y);
-			if (by >= 64) _Us79_AVX_64(data+ix, _mm256_stride_y);
-			if (by >= 128) _Us79_AVX_128(data+ix, _mm256_stride_y);
-			if (by >= 256) _Us79_AVX_256(data+ix, _mm256_stride_y);
+			for (int i = nly-1;  i >= 0;  --i) _Us79_AVX(data+ix, _mm256_stride_y, ly[i]);
 		}
 	}
 	
@@ -248,14 +224,7 @@ void Wavelet_Transform_Fast_Inverse(
 				{
 					for (int iz = 0;  iz < bz;  ++iz) tmp[iz] = data[iz*_mm256_stride_z+ix];
 
-					_Us79_AVX_2(tmp, 1);
-					_Us79_AVX_4(tmp, 1);
-					_Us79_AVX_8(tmp, 1);
-					if (bz >= 16) _Us79_AVX_16(tmp, 1);
-					if (bz >= 32) _Us79_AVX_32(tmp, 1);
-					if (bz >= 64) _Us79_AVX_64(tmp, 1);
-					if (bz >= 128) _Us79_AVX_128(tmp, 1);
-					if (bz >= 256) _Us79_AVX_256(tmp, 1);
+					for (int i = nlz-1;  i >= 0;  --i) _Us79_AVX(tmp, 1, lz[i]);
 
 					for (int iz = 0;  iz < bz;  ++iz) data[iz*_mm256_stride_z+ix] = tmp[iz];
 				}
@@ -264,17 +233,51 @@ void Wavelet_Transform_Fast_Inverse(
 			{
 				for (int ix = 0;  ix < _mm256_bx;  ++ix)
 				{
-					_Us79_AVX_2(data+ix, _mm256_stride_z);
-					_Us79_AVX_4(data+ix, _mm256_stride_z);
-					_Us79_AVX_8(data+ix, _mm256_stride_z);
-					if (bz >= 16) _Us79_AVX_16(data+ix, _mm256_stride_z);
-					if (bz >= 32) _Us79_AVX_32(data+ix, _mm256_stride_z);
-					if (bz >= 64) _Us79_AVX_64(data+ix, _mm256_stride_z);
-					if (bz >= 128) _Us79_AVX_128(data+ix, _mm256_stride_z);
-					if (bz >= 256) _Us79_AVX_256(data+ix, _mm256_stride_z);
+					for (int i = nlz-1;  i >= 0;  --i) _Us79_AVX(data+ix, _mm256_stride_z, lz[i]);
 				}
 			}
 		}
 	}
 }
 
+
+void Wavelet_Transform_Fast_Forward_T(
+	__m256* work,
+	__m256* tmp,
+	int n,
+	int bt
+	)
+{
+	int lt[16];
+	int nlt = Get_Transform_Lengths(bt,lt);
+	int _mm256_stride_t = n >> 3;
+	// snapshots are far apart, so each column is copied to tmp like the z pass does for 4096 byte strides.
+	for (int i = 0;  i < _mm256_stride_t;  ++i)
+	{
+		for (int it = 0;  it < bt;  ++it) tmp[it] = work[it*_mm256_stride_t+i];
+
+		for (int j = 0;  j < nlt;  ++j) _Ds79_AVX(tmp, 1, lt[j]);
+
+		for (int it = 0;  it < bt;  ++it) work[it*_mm256_stride_t+i] = tmp[it];
+	}
+}
+
+void Wavelet_Transform_Fast_Inverse_T(
+	__m256* work,
+	__m256* tmp,
+	int n,
+	int bt
+	)
+{
+	int lt[16];
+	int nlt = Get_Transform_Lengths(bt,lt);
+	int _mm256_stride_t = n >> 3;
+	for (int i = 0;  i < _mm256_stride_t;  ++i)
+	{
+		for (int it = 0;  it < bt;  ++it) tmp[it] = work[it*_mm256_stride_t+i];
+
+		for (int j = nlt-1;  j >= 0;  --j) _Us79_AVX(tmp, 1, lt[j]);
+
+		for (int it = 0;  it < bt;  ++it) work[it*_mm256_stride_t+i] = tmp[it];
+	}
+}
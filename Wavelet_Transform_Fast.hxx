@@ -37,4 +37,33 @@ void Wavelet_Transform_Fast_Inverse(
 	int bz
 	);
 
+/*!
+ * Perform forward wavelet transform along the time axis of bt consecutive blocks (4D block).
+ * Each block has already been transformed in space, see Wavelet_Transform_Fast_Forward.
+ * Arguments:
+ * work - pointer to the bt blocks, block it starts at work + it*n/8. must be aligned on 32 byte boundary.
+ * tmp  - temporary buffer used internally. must be at least 8*bt floats large and be aligned on 32 byte boundary.
+ * n    - number of floats in one block (bx*by*bz), multiple of 8.
+ * bt   - time block size (number of blocks)
+ *
+ */
+void Wavelet_Transform_Fast_Forward_T(
+	__m256* work,
+	__m256* tmp,
+	int n,
+	int bt
+	);
+
+/*!
+ * Perform inverse wavelet transform along the time axis of bt consecutive blocks (4D block).
+ * Arguments are the same as for Wavelet_Transform_Fast_Forward_T.
+ *
+ */
+void Wavelet_Transform_Fast_Inverse_T(
+	__m256* work,
+	__m256* tmp,
+	int n,
+	int bt
+	);
+
 #endif
@@ -0,0 +1,141 @@
+//
+// This code implements a reversible 3D integer wavelet transform based on the 5/3 lifting scheme (LeGall 5/3, lossless JPEG 2000).
+// It uses the same decomposition as the 7-9 transform, i.e. lengths n, n-n/2, ... down to 2 along each axis, with the
+// low band first and the high bands after it. Each lifting step rounds to an integer and all arithmetic wraps modulo 2^32,
+// so the inverse undoes the forward transform bit for bit, no matter what the input is.
+//
+// Lines along y and z are processed 8 at a time (adjacent x positions) so the inner loops vectorize.
+//
+
+#include "Wavelet_Transform_Int53.hxx"
+
+/*
+ * floor((a+b)/2) and floor((a+b+2)/4) with wrap around instead of overflow.
+ */
+static inline int _Half(int a, int b)
+{
+	return (int)((unsigned int)a + (unsigned int)b) >> 1;
+}
+
+static inline int _Quarter(int a, int b)
+{
+	return (int)((unsigned int)a + (unsigned int)b + 2u) >> 2;
+}
+
+/*
+ * Forward transform of lanes adjacent lines of n samples. Sample j of line l is data[j*stride+l].
+ * tmp must hold lanes*n ints.
+ */
+template<int lanes>
+static void _Fwd53(int* data, long stride, int n, int* tmp)
+{
+	for (int m = n;  m >= 2;  m = m-m/2)
+	{
+		int nh = m >> 1;
+		int nl = m - nh;
+		for (int j = 0;  j < m;  ++j) for (int l = 0;  l < lanes;  ++l) tmp[j*lanes+l] = data[j*stride+l];
+		// predict, d_i = x_2i+1 - floor((x_2i + x_2i+2) / 2). x_m mirrors to x_m-2.
+		for (int i = 0;  i < nh;  ++i)
+		{
+			int* x0 = tmp + 2*i*lanes;
+			int* x1 = x0 + lanes;
+			int* x2 = (2*i+2 < m) ? x1 + lanes : x0;
+			int* d = data + (nl+i)*stride;
+			for (int l = 0;  l < lanes;  ++l) d[l] = (int)((unsigned int)x1[l] - (unsigned int)_Half(x0[l],x2[l]));
+		}
+		// update, s_i = x_2i + floor((d_i-1 + d_i + 2) / 4). d_-1 mirrors to d_0 and d_nh to d_nh-1.
+		for (int i = 0;  i < nl;  ++i)
+		{
+			int* x0 = tmp + 2*i*lanes;
+			int* dm = data + (nl + (i > 0 ? i-1 : 0))*stride;
+			int* dp = data + (nl + (i < nh ? i : nh-1))*stride;
+			int* s = data + i*stride;
+			for (int l = 0;  l < lanes;  ++l) s[l] = (int)((unsigned int)x0[l] + (unsigned int)_Quarter(dm[l],dp[l]));
+		}
+	}
+}
+
+/*
+ * Inverse of _Fwd53.
+ */
+template<int lanes>
+static void _Inv53(int* data, long stride, int n, int* tmp)
+{
+	int len[16], nlen = 0;
+	for (int m = n;  m >= 2;  m = m-m/2) len[nlen++] = m;
+	for (int k = nlen-1;  k >= 0;  --k)
+	{
+		int m = len[k];
+		int nh = m >> 1;
+		int nl = m - nh;
+		for (int j = 0;  j < m;  ++j) for (int l = 0;  l < lanes;  ++l) tmp[j*lanes+l] = data[j*stride+l];
+		for (int i = 0;  i < nl;  ++i)
+		{
+			int* s = tmp + i*lanes;
+			int* dm = tmp + (nl + (i > 0 ? i-1 : 0))*lanes;
+			int* dp = tmp + (nl + (i < nh ? i : nh-1))*lanes;
+			int* x0 = data + 2*i*stride;
+			for (int l = 0;  l < lanes;  ++l) x0[l] = (int)((unsigned int)s[l] - (unsigned int)_Quarter(dm[l],dp[l]));
+		}
+		for (int i = 0;  i < nh;  ++i)
+		{
+			int* d = tmp + (nl+i)*lanes;
+			int* x0 = data + 2*i*stride;
+			int* x1 = x0 + stride;
+			int* x2 = (2*i+2 < m) ? x1 + stride : x0;
+			for (int l = 0;  l < lanes;  ++l) x1[l] = (int)((unsigned int)d[l] + (unsigned int)_Half(x0[l],x2[l]));
+		}
+	}
+}
+
+void Wavelet_Transform_Int53_Forward(
+	int* work,
+	int* tmp,
+	int bx,
+	int by,
+	int bz
+	)
+{
+	long stride_z = (long)bx * (long)by;
+	for (int iz = 0;  iz < bz;  ++iz)
+	{
+		// x
+		for (int iy = 0;  iy < by;  ++iy) _Fwd53<1>(work + iz*stride_z + iy*bx, 1, bx, tmp);
+		// y
+		for (int ix = 0;  ix < bx;  ix+=8) _Fwd53<8>(work + iz*stride_z + ix, bx, by, tmp);
+	}
+	// z
+	if (bz > 1)
+	{
+		for (int iy = 0;  iy < by;  ++iy)
+		{
+			for (int ix = 0;  ix < bx;  ix+=8) _Fwd53<8>(work + iy*bx + ix, stride_z, bz, tmp);
+		}
+	}
+}
+
+void Wavelet_Transform_Int53_Inverse(
+	int* work,
+	int* tmp,
+	int bx,
+	int by,
+	int bz
+	)
+{
+	long stride_z = (long)bx * (long)by;
+	// z
+	if (bz > 1)
+	{
+		for (int iy = 0;  iy < by;  ++iy)
+		{
+			for (int ix = 0;  ix < bx;  ix+=8) _Inv53<8>(work + iy*bx + ix, stride_z, bz, tmp);
+		}
+	}
+	for (int iz = 0;  iz < bz;  ++iz)
+	{
+		// y
+		for (int ix = 0;  ix < bx;  ix+=8) _Inv53<8>(work + iz*stride_z + ix, bx, by, tmp);
+		// x
+		for (int iy = 0;  iy < by;  ++iy) _Inv53<1>(work + iz*stride_z + iy*bx, 1, bx, tmp);
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef CVX_WAVELET_TRANSFORM_INT53_HXX
+#define CVX_WAVELET_TRANSFORM_INT53_HXX
+
+/*!
+ * Perform forward reversible integer wavelet transform (5/3 lifting, as in lossless JPEG 2000).
+ * Coefficients are laid out the same way as for Wavelet_Transform_Fast_Forward.
+ * All arithmetic wraps modulo 2^32, so Wavelet_Transform_Int53_Inverse reconstructs the input exactly for any input.
+ * Arguments:
+ * work - pointer to the block you want to transform.
+ * tmp  - temporary buffer used internally. must be at least 8*MAX(bx,by,bz) ints large.
+ * bx   - x block size (must be a multiple of 8)
+ * by   - y block size
+ * bz   - z block size
+ *
+ */
+void Wavelet_Transform_Int53_Forward(
+	int* work,
+	int* tmp,
+	int bx,
+	int by,
+	int bz
+	);
+
+/*!
+ * Perform inverse reversible integer wavelet transform.
+ * Arguments are the same as for Wavelet_Transform_Int53_Forward.
+ *
+ */
+void Wavelet_Transform_Int53_Inverse(
+	int* work,
+	int* tmp,
+	int bx,
+	int by,
+	int bz
+	);
+
+#endif
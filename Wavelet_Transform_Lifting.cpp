@@ -0,0 +1,388 @@
+//
+// This code implements a 3D wavelet transform based on the lifting factorization of Antonini's 7-9 tap filter (CDF 9/7).
+// It produces the same coefficients as the convolution kernels in Wavelet_Transform_Fast.cpp, but needs about half
+// the multiply-adds per output sample.
+//
+// Each level is lifted in place on the even (low) and odd (high) samples of the previous level's low band,
+// i.e. level l works on every 2^l'th sample. The lifting steps of one line form a dependency chain from one sample pair
+// to the next, so four lines are lifted together to keep the FMA units busy. The transform is not in place: every line of
+// every pass is staged through a 32KB buffer on the stack, interleaved so the four chains sit next to each other, and the
+// copy back moves the coefficients into the usual band order (low band first, then high bands from coarse to fine).
+// The copy also keeps the large, power of two strides of the y and z passes from mapping a whole line to the same few cache sets.
+//
+
+#define  SIMDE_ENABLE_NATIVE_ALIASES
+#include "simde/x86/avx.h"  // AVX intrinsics
+
+#include "Wavelet_Transform_Lifting.hxx"
+
+/*
+ * Lifting coefficients for CDF 9/7.
+ * The low band is scaled by K and the high band by 1/K to match the normalization of the 7-9 tap filter in Ds79_Base.cpp.
+ */
+#define lift_A -1.586134342059924f
+#define lift_B -0.052980118572961f
+#define lift_C  0.882911075530934f
+#define lift_D  0.443506852043971f
+#define lift_K  1.149604398860241f
+
+#ifdef __AVX2__
+#define LIFT_FMADD(a,b,c) _mm256_fmadd_ps(a,b,c)
+#else
+#define LIFT_FMADD(a,b,c) _mm256_add_ps(_mm256_mul_ps(a,b),c)
+#endif
+
+/*
+ * Everything needed to transform one axis of length n.
+ * fwd[j] is the position of the j'th coefficient (in band order) after lifting all levels in place.
+ */
+struct Lifting_Plan
+{
+	int n;
+	int nlev;
+	int len[16];
+	short fwd[256];
+};
+
+static void Build_Lifting_Plan(Lifting_Plan& plan, int n)
+{
+	plan.n = n;
+	plan.nlev = 0;
+	int step = 1;
+	for (int m = n;  m >= 2;  m = m-m/2)
+	{
+		plan.len[plan.nlev++] = m;
+		// high band of this level ends up at [m-m/2,m) and lives on the odd samples (at this level's spacing).
+		int ml = m - m/2;
+		for (int j = ml;  j < m;  ++j) plan.fwd[j] = (2*(j-ml)+1)*step;
+		step *= 2;
+	}
+	plan.fwd[0] = 0;
+}
+
+/*
+ * Lifting state carried from one sample pair to the next.
+ * s1 is the next unmodified even sample, the rest are outputs of the lifting steps for the current pair.
+ */
+struct Lifting_State
+{
+	__m256 s1, dA0, sB0, dC_prev;
+};
+
+/*
+ * Process sample pair k of one level of forward lifting on NC interleaved lines, line c starts at data[c].
+ * Each lifting step mirrors its input at the ends (whole point symmetric extension), which is what makes the result
+ * match the convolution kernels. interior=true skips the end checks and is valid for 0 < k < nl-2.
+ */
+template<bool interior, int NC>
+static inline void _Ds97_Lift_Pair_AVX(__m256* data, long stride, int nl, int nh, int k, Lifting_State* st)
+{
+	for (int c = 0;  c < NC;  ++c)
+	{
+		__m256 sB1 = st[c].sB0, dA1 = st[c].dA0;
+		if (interior || k+1 < nl)
+		{
+			__m256 s2 = (interior || k+2 < nl) ? data[(2*k+4)*stride+c] : st[c].s1;
+			if (interior || k+1 < nh) dA1 = LIFT_FMADD(_mm256_set1_ps(lift_A),_mm256_add_ps(st[c].s1,s2),data[(2*k+3)*stride+c]);
+			sB1 = LIFT_FMADD(_mm256_set1_ps(lift_B),_mm256_add_ps(st[c].dA0,dA1),st[c].s1);
+			st[c].s1 = s2;
+		}
+		__m256 dC0 = st[c].dC_prev;
+		if (interior || k < nh)
+		{
+			dC0 = LIFT_FMADD(_mm256_set1_ps(lift_C),_mm256_add_ps(st[c].sB0,sB1),st[c].dA0);
+			data[(2*k+1)*stride+c] = _mm256_mul_ps(dC0,_mm256_set1_ps(1.0f/lift_K));
+		}
+		if (!interior && k == 0) st[c].dC_prev = dC0;
+		__m256 sD0 = LIFT_FMADD(_mm256_set1_ps(lift_D),_mm256_add_ps(st[c].dC_prev,dC0),st[c].sB0);
+		data[2*k*stride+c] = _mm256_mul_ps(sD0,_mm256_set1_ps(lift_K));
+		st[c].dC_prev = dC0;
+		st[c].sB0 = sB1;
+		st[c].dA0 = dA1;
+	}
+}
+
+/*
+ * One level of forward lifting on NC interleaved lines of n vectors with given stride, in place.
+ * Low band ends up on the even samples, high band on the odd samples.
+ * The four lifting steps and the scaling are fused into a single sweep.
+ */
+template<int NC>
+static inline void _Ds97_Lift_AVX(__m256* data, long stride, int n)
+{
+	int nh = n >> 1;
+	int nl = n - nh;
+	Lifting_State st[NC];
+	for (int c = 0;  c < NC;  ++c)
+	{
+		__m256 s0 = data[c];
+		st[c].s1 = nl > 1 ? data[2*stride+c] : s0;
+		st[c].dA0 = LIFT_FMADD(_mm256_set1_ps(lift_A),_mm256_add_ps(s0,st[c].s1),data[stride+c]);
+		st[c].sB0 = LIFT_FMADD(_mm256_set1_ps(lift_B),_mm256_add_ps(st[c].dA0,st[c].dA0),s0);
+		st[c].dC_prev = _mm256_setzero_ps();
+	}
+	_Ds97_Lift_Pair_AVX<false,NC>(data,stride,nl,nh,0,st);
+	int k = 1;
+	for (;  k < nl-2;  ++k) _Ds97_Lift_Pair_AVX<true,NC>(data,stride,nl,nh,k,st);
+	for (;  k < nl;  ++k) _Ds97_Lift_Pair_AVX<false,NC>(data,stride,nl,nh,k,st);
+}
+
+/*
+ * Inverse lifting state carried from one sample pair to the next.
+ * dC0 and sB0 belong to the current pair, dA_prev and s_prev to the previous one.
+ */
+struct Unlifting_State
+{
+	__m256 s_prev, dA_prev, sB0, dC0;
+};
+
+/*
+ * Process sample pair k of one level of inverse lifting on NC interleaved lines. Outputs even sample k and odd sample k-1.
+ */
+template<bool interior, int NC>
+static inline void _Us97_Lift_Pair_AVX(__m256* data, long stride, int nl, int nh, int k, Unlifting_State* st)
+{
+	for (int c = 0;  c < NC;  ++c)
+	{
+		__m256 sB1 = st[c].sB0, dC1 = st[c].dC0;
+		if (interior || k+1 < nl)
+		{
+			if (interior || k+1 < nh) dC1 = _mm256_mul_ps(data[(2*k+3)*stride+c],_mm256_set1_ps(lift_K));
+			sB1 = LIFT_FMADD(_mm256_set1_ps(-lift_D),_mm256_add_ps(st[c].dC0,dC1),_mm256_mul_ps(data[(2*k+2)*stride+c],_mm256_set1_ps(1.0f/lift_K)));
+		}
+		__m256 dA0 = st[c].dA_prev;
+		if (interior || k < nh) dA0 = LIFT_FMADD(_mm256_set1_ps(-lift_C),_mm256_add_ps(st[c].sB0,sB1),st[c].dC0);
+		if (!interior && k == 0) st[c].dA_prev = dA0;
+		__m256 s0 = LIFT_FMADD(_mm256_set1_ps(-lift_B),_mm256_add_ps(st[c].dA_prev,dA0),st[c].sB0);
+		data[2*k*stride+c] = s0;
+		if (interior || k > 0) data[(2*k-1)*stride+c] = LIFT_FMADD(_mm256_set1_ps(-lift_A),_mm256_add_ps(st[c].s_prev,s0),st[c].dA_prev);
+		st[c].s_prev = s0;
+		st[c].dA_prev = dA0;
+		st[c].sB0 = sB1;
+		st[c].dC0 = dC1;
+	}
+}
+
+/*
+ * One level of inverse lifting on NC interleaved lines of n vectors with given stride, in place. Undoes _Ds97_Lift_AVX.
+ */
+template<int NC>
+static inline void _Us97_Lift_AVX(__m256* data, long stride, int n)
+{
+	int nh = n >> 1;
+	int nl = n - nh;
+	Unlifting_State st[NC];
+	for (int c = 0;  c < NC;  ++c)
+	{
+		st[c].dC0 = _mm256_mul_ps(data[stride+c],_mm256_set1_ps(lift_K));
+		st[c].sB0 = LIFT_FMADD(_mm256_set1_ps(-lift_D),_mm256_add_ps(st[c].dC0,st[c].dC0),_mm256_mul_ps(data[c],_mm256_set1_ps(1.0f/lift_K)));
+		st[c].dA_prev = _mm256_setzero_ps();
+		st[c].s_prev = _mm256_setzero_ps();
+	}
+	_Us97_Lift_Pair_AVX<false,NC>(data,stride,nl,nh,0,st);
+	int k = 1;
+	for (;  k < nl-2;  ++k) _Us97_Lift_Pair_AVX<true,NC>(data,stride,nl,nh,k,st);
+	for (;  k < nl;  ++k) _Us97_Lift_Pair_AVX<false,NC>(data,stride,nl,nh,k,st);
+	if (nh == nl)
+		for (int c = 0;  c < NC;  ++c)
+			data[(2*nh-1)*stride+c] = LIFT_FMADD(_mm256_set1_ps(-lift_A),_mm256_add_ps(st[c].s_prev,st[c].s_prev),st[c].dA_prev);
+}
+
+/*
+ * Forward transform of NC interleaved lines in buf, sample k of line c is buf[k*NC+c]. Output is left in lifting order.
+ */
+template<int NC>
+static inline void _Ds97_Lines_AVX(__m256* buf, const Lifting_Plan& plan)
+{
+	for (int i = 0, lev_stride = NC;  i < plan.nlev;  ++i, lev_stride *= 2) _Ds97_Lift_AVX<NC>(buf, lev_stride, plan.len[i]);
+}
+
+/*
+ * Inverse transform of NC interleaved lines in buf. Input is in lifting order.
+ */
+template<int NC>
+static inline void _Us97_Lines_AVX(__m256* buf, const Lifting_Plan& plan)
+{
+	for (int i = plan.nlev-1, lev_stride = NC << (plan.nlev-1);  i >= 0;  --i, lev_stride /= 2) _Us97_Lift_AVX<NC>(buf, lev_stride, plan.len[i]);
+}
+
+/*
+ * Transform the lines of one pass through buf, nline lines of plan.n vectors, line l starts at data + (l/nrow)*outer + l%nrow
+ * and its samples are stride vectors apart. Lines are done four at a time, the last few one at a time.
+ * The band order permutation is folded into the copies.
+ */
+template<bool forward>
+static void _Lift_Lines_AVX(__m256* data, long nline, int nrow, long outer, long stride, const Lifting_Plan& plan, __m256* buf)
+{
+	int n = plan.n;
+	long l = 0;
+	for (;  l+4 <= nline;  l += 4)
+	{
+		__m256* base[4];
+		for (int c = 0;  c < 4;  ++c) base[c] = data + ((l+c)/nrow)*outer + (l+c)%nrow;
+		if (forward)
+		{
+			for (int k = 0;  k < n;  ++k)
+				for (int c = 0;  c < 4;  ++c) buf[k*4+c] = base[c][k*stride];
+			_Ds97_Lines_AVX<4>(buf,plan);
+			for (int k = 0;  k < n;  ++k)
+				for (int c = 0;  c < 4;  ++c) base[c][k*stride] = buf[plan.fwd[k]*4+c];
+		}
+		else
+		{
+			for (int k = 0;  k < n;  ++k)
+				for (int c = 0;  c < 4;  ++c) buf[plan.fwd[k]*4+c] = base[c][k*stride];
+			_Us97_Lines_AVX<4>(buf,plan);
+			for (int k = 0;  k < n;  ++k)
+				for (int c = 0;  c < 4;  ++c) base[c][k*stride] = buf[k*4+c];
+		}
+	}
+	for (;  l < nline;  ++l)
+	{
+		__m256* base = data + (l/nrow)*outer + l%nrow;
+		if (forward)
+		{
+			for (int k = 0;  k < n;  ++k) buf[k] = base[k*stride];
+			_Ds97_Lines_AVX<1>(buf,plan);
+			for (int k = 0;  k < n;  ++k) base[k*stride] = buf[plan.fwd[k]];
+		}
+		else
+		{
+			for (int k = 0;  k < n;  ++k) buf[plan.fwd[k]] = base[k*stride];
+			_Us97_Lines_AVX<1>(buf,plan);
+			for (int k = 0;  k < n;  ++k) base[k*stride] = buf[k];
+		}
+	}
+}
+
+/*
+ * Transpose 8 rows of x into line c of NC interleaved lines in tmp, so that each vector holds one x sample from 8 y lines.
+ * If perm is given, row j is stored at position perm[j] of the line.
+ */
+static inline void _Transpose_In(__m128* data, int _mm_bx, __m256* tmp, int NC, int c, const short* perm)
+{
+	for (int ix = 0;  ix < _mm_bx;  ++ix)
+	{
+		__m128 v0 = data[ix];
+		__m128 v1 = data[ix+_mm_bx];
+		__m128 v2 = data[ix+2*_mm_bx];
+		__m128 v3 = data[ix+3*_mm_bx];
+		_MM_TRANSPOSE4_PS(v0,v1,v2,v3);
+		__m128 v4 = data[ix+4*_mm_bx];
+		__m128 v5 = data[ix+5*_mm_bx];
+		__m128 v6 = data[ix+6*_mm_bx];
+		__m128 v7 = data[ix+7*_mm_bx];
+		_MM_TRANSPOSE4_PS(v4,v5,v6,v7);
+		int j = ix*4;
+		tmp[(perm ? perm[j  ] : j  )*NC+c] = _mm256_insertf128_ps(_mm256_castps128_ps256(v0),v4,1);
+		tmp[(perm ? perm[j+1] : j+1)*NC+c] = _mm256_insertf128_ps(_mm256_castps128_ps256(v1),v5,1);
+		tmp[(perm ? perm[j+2] : j+2)*NC+c] = _mm256_insertf128_ps(_mm256_castps128_ps256(v2),v6,1);
+		tmp[(perm ? perm[j+3] : j+3)*NC+c] = _mm256_insertf128_ps(_mm256_castps128_ps256(v3),v7,1);
+	}
+}
+
+/*
+ * Inverse of _Transpose_In. If perm is given, row j is read from position perm[j] of the line.
+ */
+static inline void _Transpose_Out(__m256* tmp, int NC, int c, __m128* data, int _mm_bx, const short* perm)
+{
+	for (int ix = 0;  ix < _mm_bx;  ++ix)
+	{
+		int j = ix*4;
+		__m256 lv0 = tmp[(perm ? perm[j  ] : j  )*NC+c];
+		__m256 lv1 = tmp[(perm ? perm[j+1] : j+1)*NC+c];
+		__m256 lv2 = tmp[(perm ? perm[j+2] : j+2)*NC+c];
+		__m256 lv3 = tmp[(perm ? perm[j+3] : j+3)*NC+c];
+		__m128 v0 = _mm256_extractf128_ps(lv0,0);
+		__m128 v1 = _mm256_extractf128_ps(lv1,0);
+		__m128 v2 = _mm256_extractf128_ps(lv2,0);
+		__m128 v3 = _mm256_extractf128_ps(lv3,0);
+		_MM_TRANSPOSE4_PS(v0,v1,v2,v3);
+		__m128 v4 = _mm256_extractf128_ps(lv0,1);
+		__m128 v5 = _mm256_extractf128_ps(lv1,1);
+		__m128 v6 = _mm256_extractf128_ps(lv2,1);
+		__m128 v7 = _mm256_extractf128_ps(lv3,1);
+		_MM_TRANSPOSE4_PS(v4,v5,v6,v7);
+		data[ix] = v0;
+		data[ix+_mm_bx] = v1;
+		data[ix+2*_mm_bx] = v2;
+		data[ix+3*_mm_bx] = v3;
+		data[ix+4*_mm_bx] = v4;
+		data[ix+5*_mm_bx] = v5;
+		data[ix+6*_mm_bx] = v6;
+		data[ix+7*_mm_bx] = v7;
+	}
+}
+
+/*
+ * x pass over ngroup groups of 8 rows starting at data, four groups at a time like _Lift_Lines_AVX.
+ */
+template<bool forward>
+static void _Lift_Rows_AVX(__m128* data, long ngroup, int _mm_bx, const Lifting_Plan& plan, __m256* buf)
+{
+	long g = 0;
+	for (;  g+4 <= ngroup;  g += 4)
+	{
+		for (int c = 0;  c < 4;  ++c) _Transpose_In(data+(g+c)*8*_mm_bx,_mm_bx,buf,4,c,forward ? 0L : plan.fwd);
+		if (forward) _Ds97_Lines_AVX<4>(buf,plan); else _Us97_Lines_AVX<4>(buf,plan);
+		for (int c = 0;  c < 4;  ++c) _Transpose_Out(buf,4,c,data+(g+c)*8*_mm_bx,_mm_bx,forward ? plan.fwd : 0L);
+	}
+	for (;  g < ngroup;  ++g)
+	{
+		_Transpose_In(data+g*8*_mm_bx,_mm_bx,buf,1,0,forward ? 0L : plan.fwd);
+		if (forward) _Ds97_Lines_AVX<1>(buf,plan); else _Us97_Lines_AVX<1>(buf,plan);
+		_Transpose_Out(buf,1,0,data+g*8*_mm_bx,_mm_bx,forward ? plan.fwd : 0L);
+	}
+}
+
+/*
+ * Forward or inverse transform of a block. Slices are done a few at a time, x and y pass on each chunk while it is in cache,
+ * with enough rows and y lines in a chunk to lift four of them together. The z pass follows on the whole block.
+ */
+template<bool forward>
+static void _Lift_Block_AVX(__m256* work, int bx, int by, int bz)
+{
+	// four interleaved lines of up to 256 vectors.
+	__m256 buf[4*256];
+	int _mm_bx = bx >> 2;
+	int _mm256_bx = bx >> 3;
+	long _mm256_stride_z = (long)by * (long)_mm256_bx;
+	Lifting_Plan px, py, pz;
+	Build_Lifting_Plan(px,bx);
+	Build_Lifting_Plan(py,by);
+	Build_Lifting_Plan(pz,bz);
+	int zc = 1;
+	while (zc < bz && (zc*_mm256_bx < 4 || zc*by < 32)) zc *= 2;
+	for (int iz = 0;  iz < bz;  iz += zc)
+	{
+		int nz = bz - iz < zc ? bz - iz : zc;
+		__m256* slice = work + iz*_mm256_stride_z;
+		// x
+		_Lift_Rows_AVX<forward>((__m128*)slice,(long)nz*by/8,_mm_bx,px,buf);
+		// y, line l of the chunk is x vector l%_mm256_bx of slice l/_mm256_bx.
+		_Lift_Lines_AVX<forward>(slice,(long)nz*_mm256_bx,_mm256_bx,_mm256_stride_z,_mm256_bx,py,buf);
+	}
+
+	// z, line l is x vector l of row 0, which is the same as x vector l%_mm256_bx of row l/_mm256_bx.
+	if (bz > 1) _Lift_Lines_AVX<forward>(work,_mm256_stride_z,_mm256_stride_z,0,_mm256_stride_z,pz,buf);
+}
+
+void Wavelet_Transform_Lifting_Forward(
+	__m256* work,
+	int bx,
+	int by,
+	int bz
+	)
+{
+	_Lift_Block_AVX<true>(work,bx,by,bz);
+}
+
+void Wavelet_Transform_Lifting_Inverse(
+	__m256* work,
+	int bx,
+	int by,
+	int bz
+	)
+{
+	_Lift_Block_AVX<false>(work,bx,by,bz);
+}
@@ -0,0 +1,41 @@
+#ifndef CVX_WAVELET_TRANSFORM_LIFTING_HXX
+#define CVX_WAVELET_TRANSFORM_LIFTING_HXX
+
+/*!
+ * Perform forward wavelet transform using the lifting factorization of the 7-9 tap filter.
+ * Produces the same coefficients as Wavelet_Transform_Fast_Forward (to within float rounding),
+ * so blocks transformed with either engine can be inverted with either engine.
+ * Lines are still staged through a buffer, four at a time. It lives on the stack, so there is no tmp argument.
+ * Timings from module test 4 against the convolution kernels: 28% and 11% slower for 8^3 and 16^3 blocks,
+ * about equal for 32^3 and 64^3, faster only for 128^3 and 256^3.
+ * Arguments:
+ * work - pointer to the block you want to transform. must be aligned on 32 byte boundary.
+ * bx   - x block size (number of floats)
+ * by   - y block size (number of floats)
+ * bz   - z block size (number of floats)
+ *
+ */
+void Wavelet_Transform_Lifting_Forward(
+	__m256* work,
+	int bx,
+	int by,
+	int bz
+	);
+
+/*!
+ * Perform inverse wavelet transform using the lifting factorization of the 7-9 tap filter.
+ * Arguments:
+ * work - pointer to the block you want to transform. must be aligned on 32 byte boundary.
+ * bx   - x block size (number of floats)
+ * by   - y block size (number of floats)
+ * bz   - z block size (number of floats)
+ *
+ */
+void Wavelet_Transform_Lifting_Inverse(
+	__m256* work,
+	int bx,
+	int by,
+	int bz
+	);
+
+#endif
@@ -174,27 +174,33 @@ Ds79(
  * nl
  * nl-1 -> nl
  * nl-2 -> nl+1
+ *
+ * The above holds for even n. For odd n, the forward transform mirrors around an even sample at n-1,
+ * so the upper end is mirrored around the last sample for SL coefficients (nl -> nl-2)
+ * and between the last two samples for SH coefficients (n -> n-1).
  */
-inline int MIRR_SL(int inp_val, int nl)
+inline int MIRR_SL(int inp_val, int nl, int nh)
 {
+	int hi = (nl == nh) ? 2*nl-1 : 2*nl-2;
 	int val = inp_val;
 	val = val < 0 ? -val : val;
-	val = (val >= nl) ? (2*nl-1-val) : val;
+	val = (val >= nl) ? (hi-val) : val;
 	val = val < 0 ? -val : val;
-	val = (val >= nl) ? (2*nl-1-val) : val;
+	val = (val >= nl) ? (hi-val) : val;
 	val = val < 0 ? -val : val;
-	val = (val >= nl) ? (2*nl-1-val) : val;
+	val = (val >= nl) ? (hi-val) : val;
 	return val;
 }
 inline int MIRR_SH(int inp_val, int nl, int nh)
 {
+	int hi = (nl == nh) ? 2*nh-2 : 2*nh-1;
 	int val = inp_val - nl;
 	val = val < 0 ? -val-1 : val;
-	val = (val >= nh) ? (2*nh-2-val) : val;
+	val = (val >= nh) ? (hi-val) : val;
 	val = val < 0 ? -val-1 : val;
-	val = (val >= nh) ? (2*nh-2-val) : val;
+	val = (val >= nh) ? (hi-val) : val;
 	val = val < 0 ? -val-1 : val;
-	val = (val >= nh) ? (2*nh-2-val) : val;
+	val = (val >= nh) ? (hi-val) : val;
 	return nl + val;
 }
 
@@ -229,19 +235,19 @@ Us79(
 		//printf("  -> n=%d, nh=%d, nl=%d\n",n,nh,nl);
 		for (int k = 0;  k < nl;  ++k)
 		{
-			if (Verbose) printf("d[%d] = sl0*t[%d] + sl2*(t[%d]+t[%d]) + sh1*(t[%d]+t[%d]) + sh3*(t[%d]+t[%d])\n",2*k,k,MIRR_SL(k-1,nl),MIRR_SL(k+1,nl),MIRR_SH(nl+k-1,nl,nh),MIRR_SH(nl+k,nl,nh),MIRR_SH(nl+k-2,nl,nh),MIRR_SH(nl+k+1,nl,nh));
+			if (Verbose) printf("d[%d] = sl0*t[%d] + sl2*(t[%d]+t[%d]) + sh1*(t[%d]+t[%d]) + sh3*(t[%d]+t[%d])\n",2*k,k,MIRR_SL(k-1,nl,nh),MIRR_SL(k+1,nl,nh),MIRR_SH(nl+k-1,nl,nh),MIRR_SH(nl+k,nl,nh),MIRR_SH(nl+k-2,nl,nh),MIRR_SH(nl+k+1,nl,nh));
 			p_in[2*k*stride] = 
 				sl0 * t[k] + 
-				sl2 * ( t[MIRR_SL(k-1,nl)] + t[MIRR_SL(k+1,nl)] ) +
+				sl2 * ( t[MIRR_SL(k-1,nl,nh)] + t[MIRR_SL(k+1,nl,nh)] ) +
 				sh1 * ( t[MIRR_SH(nl+k-1,nl,nh)] + t[MIRR_SH(nl+k,nl,nh)] ) +
 				sh3 * ( t[MIRR_SH(nl+k-2,nl,nh)] + t[MIRR_SH(nl+k+1,nl,nh)] );
 		}
 		for (int k = 0;  k < nh;  ++k)
 		{
-			if (Verbose) printf("d[%d] = sl1*(t[%d]+t[%d]) + sl3*(t[%d]+t[%d]) + sh0*t[%d] + sh2*(t[%d]+t[%d]) + sh4*(t[%d]+t[%d])\n",(2*k+1),MIRR_SL(k,nl),MIRR_SL(k+1,nl),MIRR_SL(k-1,nl),MIRR_SL(k+2,nl),nl+k,MIRR_SH(nl+k-1,nl,nh),MIRR_SH(nl+k+1,nl,nh),MIRR_SH(nl+k-2,nl,nh),MIRR_SH(nl+k+2,nl,nh));
+			if (Verbose) printf("d[%d] = sl1*(t[%d]+t[%d]) + sl3*(t[%d]+t[%d]) + sh0*t[%d] + sh2*(t[%d]+t[%d]) + sh4*(t[%d]+t[%d])\n",(2*k+1),MIRR_SL(k,nl,nh),MIRR_SL(k+1,nl,nh),MIRR_SL(k-1,nl,nh),MIRR_SL(k+2,nl,nh),nl+k,MIRR_SH(nl+k-1,nl,nh),MIRR_SH(nl+k+1,nl,nh),MIRR_SH(nl+k-2,nl,nh),MIRR_SH(nl+k+2,nl,nh));
 			p_in[(2*k+1)*stride] = 
-				sl1 * ( t[MIRR_SL(k,nl)] + t[MIRR_SL(k+1,nl)] ) +
-				sl3 * ( t[MIRR_SL(k-1,nl)] + t[MIRR_SL(k+2,nl)] ) +
+				sl1 * ( t[MIRR_SL(k,nl,nh)] + t[MIRR_SL(k+1,nl,nh)] ) +
+				sl3 * ( t[MIRR_SL(k-1,nl,nh)] + t[MIRR_SL(k+2,nl,nh)] ) +
 				sh0 * t[nl+k] +
 				sh2 * ( t[MIRR_SH(nl+k-1,nl,nh)] + t[MIRR_SH(nl+k+1,nl,nh)] ) +
 				sh4 * ( t[MIRR_SH(nl+k-2,nl,nh)] + t[MIRR_SH(nl+k+2,nl,nh)] );
@@ -302,10 +308,40 @@ void Wavelet_Transform_Slow_Inverse(
 
 //
 // Code generator. Generates the base AVX and AVX2 implementations of the wavelet forward and inverse transforms.
-// Only powers of two are supported for the time being. Would be easy to extend to arbitrary lengths, but this
-// wasn't necessary for the compression library.
+// A block size of n is decomposed into transforms of length n, n-n/2, ... down to 2, so a base function is
+// generated for every length that appears in the decomposition of a supported block size.
 //
 
+/*
+ * Flag every transform length needed by block sizes min_bs, min_bs+bs_step, ..., max_bs.
+ * needed must have room for max_bs+1 entries.
+ */
+static void Find_Transform_Lengths(int min_bs, int max_bs, int bs_step, bool* needed)
+{
+	for (int i = 0;  i <= max_bs;  ++i) needed[i] = false;
+	for (int bs = min_bs;  bs <= max_bs;  bs += bs_step)
+	{
+		for (int n = bs;  n >= 2;  n = n-n/2) needed[n] = true;
+	}
+}
+
+/*
+ * Print a function that dispatches to the base function for transform length n.
+ */
+static void Gen_Dispatch(FILE* fp, const char* name, bool* needed, int max_bs)
+{
+	fprintf(fp,"/*\n");
+	fprintf(fp," * Dispatch to the base function for a transform of length n.\n");
+	fprintf(fp," */\n");
+	fprintf(fp,"static inline void %s(__m256* data, int stride, int n)\n",name);
+	fprintf(fp,"{\n");
+	fprintf(fp,"\tswitch (n)\n");
+	fprintf(fp,"\t{\n");
+	for (int n = 2;  n <= max_bs;  ++n) if (needed[n]) fprintf(fp,"\tcase %d: %s_%d(data,stride); break;\n",n,name,n);
+	fprintf(fp,"\t}\n");
+	fprintf(fp,"}\n");
+}
+
 int Find_Index(int* var_prev_idx, int prev_n, int idx)
 {
 	if (idx >= 0)
@@ -448,6 +484,7 @@ void Gen_Ds79_Core(FILE* fp, int n, int num_vars, bool avx2)
                         fprintf(fp,"\tdata[%d*stride] = acc1;\n",ix);
                 }
 
+                if (ix < nh)  // odd lengths have one more lower band sample than upper band samples
                 {
                         fprintf(fp,"\n\t// upper band :: ix=%d\n",ix);
                         int i0 = 2 * ix + 1;
@@ -493,13 +530,16 @@ void Gen_Ds79_Core(FILE* fp, int n, int num_vars, bool avx2)
         fprintf(fp,"}\n\n");
 }
 
-void Gen_Ds79(const char* path, int min_n, int max_n, int num_vars)
+void Gen_Ds79(const char* path, int min_bs, int max_bs, int bs_step, int num_vars)
 {
+	bool* needed = new bool[max_bs+1];
+	Find_Transform_Lengths(min_bs,max_bs,bs_step,needed);
+
 	FILE* fp = fopen(path, "w");
 
 	fprintf(fp,"/*!\n");
 	fprintf(fp," * Don't edit this code, it was automatically generated.\n");
-	fprintf(fp," * Base functions for wavelet transforms of length %d to %d.\n",1<<min_n,1<<max_n);
+	fprintf(fp," * Base functions for wavelet transforms of block sizes %d to %d in steps of %d.\n",min_bs,max_bs,bs_step);
 	fprintf(fp," */\n\n");
 	fprintf(fp,"#define  SIMDE_ENABLE_NATIVE_ALIASES \n");
 	fprintf(fp,"#include \"simde/x86/avx.h\"  // AVX intrinsics\n\n");
@@ -531,15 +571,18 @@ void Gen_Ds79(const char* path, int min_n, int max_n, int num_vars)
 
 	fprintf(fp,"#ifdef __AVX2__\n\n");
 
-	for (int i = min_n;  i <= max_n;  ++i) Gen_Ds79_Core(fp,1<<i,num_vars,true);
+	for (int n = 2;  n <= max_bs;  ++n) if (needed[n]) Gen_Ds79_Core(fp,n,num_vars,true);
 
 	fprintf(fp,"#else\n\n");
 
-	for (int i = min_n;  i <= max_n;  ++i) Gen_Ds79_Core(fp,1<<i,num_vars,false);
+	for (int n = 2;  n <= max_bs;  ++n) if (needed[n]) Gen_Ds79_Core(fp,n,num_vars,false);
+
+	fprintf(fp,"#endif\n\n");
 
-	fprintf(fp,"#endif\n");
+	Gen_Dispatch(fp,"_Ds79_AVX",needed,max_bs);
 
 	fclose(fp);
+	delete [] needed;
 	
 	printf("Wrote Ds79 base code to file %s.\n",path);
 }
@@ -592,7 +635,7 @@ void Gen_Us79_Core(FILE* fp, int n, int num_vars, bool avx2)
 			fprintf(fp,"\n\t// even samples :: k=%d\n",2*k);
 			int i0 = k;
 			int im1 = MIRR_SH(nl+k-1,nl,nh);  int ip1 = MIRR_SH(nl+k,nl,nh);
-			int im2 = MIRR_SL(k-1,nl);        int ip2 = MIRR_SL(k+1,nl);
+			int im2 = MIRR_SL(k-1,nl,nh);        int ip2 = MIRR_SL(k+1,nl,nh);
 			int im3 = MIRR_SH(nl+k-2,nl,nh);  int ip3 = MIRR_SH(nl+k+1,nl,nh);
 			var_curr_idx[0] = im3;
 			var_curr_idx[1] = im2;
@@ -605,7 +648,7 @@ void Gen_Us79_Core(FILE* fp, int n, int num_vars, bool avx2)
 			/*
 			p_in[2*k*stride] = 
 				sl0 * t[k] + 
-				sl2 * ( t[MIRR_SL(k-1,nl)] + t[MIRR_SL(k+1,nl)] ) +
+				sl2 * ( t[MIRR_SL(k-1,nl,nh)] + t[MIRR_SL(k+1,nl,nh)] ) +
 				sh1 * ( t[MIRR_SH(nl+k-1,nl,nh)] + t[MIRR_SH(nl+k,nl,nh)] ) +
 				sh3 * ( t[MIRR_SH(nl+k-2,nl,nh)] + t[MIRR_SH(nl+k+1,nl,nh)] );
 				*/
@@ -637,12 +680,13 @@ void Gen_Us79_Core(FILE* fp, int n, int num_vars, bool avx2)
 			if (!tmp_array) Print_Load_Line(fp,2*k,tmp_array,var_prev_idx,num_vars,var_curr_idx,7);
                         fprintf(fp,"\tdata[%d*stride] = acc1;\n",2*k);
 		}
+		if (k < nh)  // odd lengths have one more even sample than odd samples
 		{
                         fprintf(fp,"\n\t// odd samples :: k=%d\n",2*k+1);
 			int i0 = nl+k;
-			int im1 = MIRR_SL(k,nl);          int ip1 = MIRR_SL(k+1,nl);
+			int im1 = MIRR_SL(k,nl,nh);          int ip1 = MIRR_SL(k+1,nl,nh);
 			int im2 = MIRR_SH(nl+k-1,nl,nh);  int ip2 = MIRR_SH(nl+k+1,nl,nh);
-			int im3 = MIRR_SL(k-1,nl);        int ip3 = MIRR_SL(k+2,nl);
+			int im3 = MIRR_SL(k-1,nl,nh);        int ip3 = MIRR_SL(k+2,nl,nh);
 			int im4 = MIRR_SH(nl+k-2,nl,nh);  int ip4 = MIRR_SH(nl+k+2,nl,nh);
 			var_curr_idx[0] = im4;
 			var_curr_idx[1] = im3;
@@ -655,8 +699,8 @@ void Gen_Us79_Core(FILE* fp, int n, int num_vars, bool avx2)
 			var_curr_idx[8] = ip4;
 			/*
 			p_in[(2*k+1)*stride] = 
-				sl1 * ( t[MIRR_SL(k,nl)] + t[MIRR_SL(k+1,nl)] ) +
-				sl3 * ( t[MIRR_SL(k-1,nl)] + t[MIRR_SL(k+2,nl)] ) +
+				sl1 * ( t[MIRR_SL(k,nl,nh)] + t[MIRR_SL(k+1,nl,nh)] ) +
+				sl3 * ( t[MIRR_SL(k-1,nl,nh)] + t[MIRR_SL(k+2,nl,nh)] ) +
 				sh0 * t[nl+k] +
 				sh2 * ( t[MIRR_SH(nl+k-1,nl,nh)] + t[MIRR_SH(nl+k+1,nl,nh)] ) +
 				sh4 * ( t[MIRR_SH(nl+k-2,nl,nh)] + t[MIRR_SH(nl+k+2,nl,nh)] );
@@ -699,13 +743,16 @@ void Gen_Us79_Core(FILE* fp, int n, int num_vars, bool avx2)
         fprintf(fp,"}\n\n");
 }
 
-void Gen_Us79(const char* path, int min_n, int max_n, int num_vars)
+void Gen_Us79(const char* path, int min_bs, int max_bs, int bs_step, int num_vars)
 {
+	bool* needed = new bool[max_bs+1];
+	Find_Transform_Lengths(min_bs,max_bs,bs_step,needed);
+
 	FILE* fp = fopen(path, "w");
 
 	fprintf(fp,"/*!\n");
 	fprintf(fp," * Don't edit this code, it was automatically generated.\n");
-	fprintf(fp," * Base functions for wavelet transforms of length %d to %d.\n",1<<min_n,1<<max_n);
+	fprintf(fp," * Base functions for wavelet transforms of block sizes %d to %d in steps of %d.\n",min_bs,max_bs,bs_step);
 	fprintf(fp," */\n");
 
 	fprintf(fp,"/*\n");
@@ -735,15 +782,18 @@ void Gen_Us79(const char* path, int min_n, int max_n, int num_vars)
 
 	fprintf(fp,"#ifdef __AVX2__\n\n");
 
-	for (int i = min_n;  i <= max_n;  ++i) Gen_Us79_Core(fp,1<<i,num_vars,true);
+	for (int n = 2;  n <= max_bs;  ++n) if (needed[n]) Gen_Us79_Core(fp,n,num_vars,true);
 
 	fprintf(fp,"#else\n\n");
 
-	for (int i = min_n;  i <= max_n;  ++i) Gen_Us79_Core(fp,1<<i,num_vars,false);
+	for (int n = 2;  n <= max_bs;  ++n) if (needed[n]) Gen_Us79_Core(fp,n,num_vars,false);
+
+	fprintf(fp,"#endif\n\n");
 
-	fprintf(fp,"#endif\n");
+	Gen_Dispatch(fp,"_Us79_AVX",needed,max_bs);
 
 	fclose(fp);
+	delete [] needed;
 	
 	printf("Wrote Us79 base code to file %s.\n",path);
 }
@@ -29,7 +29,7 @@ void Wavelet_Transform_Slow_Inverse(
 	int nz
 	);
 
-void Gen_Ds79(const char* path, int min_n, int max_n, int num_vars);
-void Gen_Us79(const char* path, int min_n, int max_n, int num_vars);
+void Gen_Ds79(const char* path, int min_bs, int max_bs, int bs_step, int num_vars);
+void Gen_Us79(const char* path, int min_bs, int max_bs, int bs_step, int num_vars);
 
 #endif